@@ -0,0 +1,208 @@
+#include "archiveindex.h"
+
+#include <QDir>
+#include <QHash>
+#include <QList>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+namespace {
+const quint32 indexMagic = 0x4957424d; // "MBWI"
+const quint32 indexVersion = 1;
+}
+
+ArchiveIndex::ArchiveIndex(const QString &filePath)
+{
+    QString path = filePath;
+    if (path.isEmpty()) {
+        QString dataDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+        QDir().mkpath(dataDir);
+        path = dataDir + "/archive.idx";
+    }
+    file.setFileName(path);
+    map();
+}
+
+ArchiveIndex::~ArchiveIndex()
+{
+    unmap();
+}
+
+bool ArchiveIndex::map()
+{
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    qint64 size = file.size();
+    if (size < qint64(sizeof(Header))) {
+        file.close();
+        return false;
+    }
+
+    mapped = file.map(0, size);
+    if (!mapped) {
+        file.close();
+        return false;
+    }
+
+    // 校验文件头，记录表和字符串表都必须在文件范围内
+    const Header *h = reinterpret_cast<const Header *>(mapped);
+    qint64 recordsEnd = qint64(sizeof(Header)) + qint64(h->dayCount) * qint64(sizeof(DayRecord));
+    if (h->magic != indexMagic || h->version != indexVersion
+        || recordsEnd > h->stringsOffset
+        || qint64(h->stringsOffset) + h->stringsSize > size) {
+        unmap();
+        return false;
+    }
+
+    header = h;
+    records = reinterpret_cast<const DayRecord *>(mapped + sizeof(Header));
+    strings = reinterpret_cast<const char *>(mapped + h->stringsOffset);
+    return true;
+}
+
+void ArchiveIndex::unmap()
+{
+    if (mapped) {
+        file.unmap(mapped);
+        mapped = nullptr;
+    }
+    header = nullptr;
+    records = nullptr;
+    strings = nullptr;
+    file.close();
+}
+
+const ArchiveIndex::DayRecord *ArchiveIndex::record(const QDate &date) const
+{
+    if (!header) {
+        return nullptr;
+    }
+
+    qint64 offset = date.toJulianDay() - header->firstDay;
+    if (offset < 0 || offset >= header->dayCount) {
+        return nullptr;
+    }
+
+    const DayRecord *rec = records + offset;
+    if (rec->titleLength == 0 || rec->urlLength == 0
+        || qint64(rec->titleOffset) + rec->titleLength > header->stringsSize
+        || qint64(rec->urlOffset) + rec->urlLength > header->stringsSize) {
+        return nullptr;
+    }
+    return rec;
+}
+
+bool ArchiveIndex::lookup(const QDate &date, QString *imgtitle, QString *imgurl) const
+{
+    auto it = pending.constFind(date.toJulianDay());
+    if (it != pending.constEnd()) {
+        *imgtitle = it->first;
+        *imgurl = it->second;
+        return true;
+    }
+
+    const DayRecord *rec = record(date);
+    if (!rec) {
+        return false;
+    }
+
+    *imgtitle = QString::fromUtf8(strings + rec->titleOffset, rec->titleLength);
+    *imgurl = QString::fromUtf8(strings + rec->urlOffset, rec->urlLength);
+    return true;
+}
+
+bool ArchiveIndex::contains(const QDate &date) const
+{
+    return record(date) != nullptr || pending.contains(date.toJulianDay());
+}
+
+int ArchiveIndex::dayCount() const
+{
+    return header ? int(header->dayCount) : 0;
+}
+
+void ArchiveIndex::insert(const QDate &date, const QString &imgtitle, const QString &imgurl)
+{
+    if (date < firstDate() || imgtitle.isEmpty() || imgurl.isEmpty()) {
+        return;
+    }
+
+    // 已有相同记录时跳过，避免无意义的重写
+    QString oldTitle, oldUrl;
+    if (lookup(date, &oldTitle, &oldUrl) && oldTitle == imgtitle && oldUrl == imgurl) {
+        return;
+    }
+    pending.insert(date.toJulianDay(), qMakePair(imgtitle, imgurl));
+}
+
+bool ArchiveIndex::commit()
+{
+    if (pending.isEmpty()) {
+        return true;
+    }
+
+    // 合并已有记录与新记录
+    const qint64 firstDay = firstDate().toJulianDay();
+    qint64 dayCount = header ? header->dayCount : 0;
+    dayCount = qMax(dayCount, pending.lastKey() - firstDay + 1);
+
+    QList<DayRecord> newRecords(dayCount, DayRecord{0, 0, 0, 0});
+    QByteArray stringTable;
+    QHash<QByteArray, quint32> stringOffsets;
+    auto addString = [&stringTable, &stringOffsets](const QByteArray &text) -> quint32 {
+        auto it = stringOffsets.constFind(text);
+        if (it != stringOffsets.constEnd()) {
+            return it.value();
+        }
+        quint32 offset = quint32(stringTable.size());
+        stringTable.append(text);
+        stringOffsets.insert(text, offset);
+        return offset;
+    };
+
+    for (qint64 i = 0; i < dayCount; ++i) {
+        QByteArray title, url;
+        auto it = pending.constFind(firstDay + i);
+        if (it != pending.constEnd()) {
+            title = it->first.toUtf8();
+            url = it->second.toUtf8();
+        } else if (const DayRecord *old = record(QDate::fromJulianDay(firstDay + i))) {
+            title = QByteArray(strings + old->titleOffset, old->titleLength);
+            url = QByteArray(strings + old->urlOffset, old->urlLength);
+        } else {
+            continue;
+        }
+        DayRecord &rec = newRecords[i];
+        rec.titleOffset = addString(title);
+        rec.titleLength = quint32(title.size());
+        rec.urlOffset = addString(url);
+        rec.urlLength = quint32(url.size());
+    }
+
+    Header newHeader;
+    newHeader.magic = indexMagic;
+    newHeader.version = indexVersion;
+    newHeader.firstDay = quint32(firstDay);
+    newHeader.dayCount = quint32(dayCount);
+    newHeader.stringsOffset = quint32(sizeof(Header) + dayCount * sizeof(DayRecord));
+    newHeader.stringsSize = quint32(stringTable.size());
+
+    // Windows下被映射的文件无法替换，写入前先解除映射
+    unmap();
+
+    QSaveFile saveFile(file.fileName());
+    bool written = saveFile.open(QIODevice::WriteOnly)
+        && saveFile.write(reinterpret_cast<const char *>(&newHeader), sizeof(Header)) == qint64(sizeof(Header))
+        && saveFile.write(reinterpret_cast<const char *>(newRecords.constData()), dayCount * sizeof(DayRecord))
+               == qint64(dayCount * sizeof(DayRecord))
+        && saveFile.write(stringTable) == stringTable.size()
+        && saveFile.commit();
+
+    if (written) {
+        pending.clear();
+    }
+    map();
+    return written;
+}
@@ -0,0 +1,59 @@
+#ifndef ARCHIVEINDEX_H
+#define ARCHIVEINDEX_H
+
+#include <QString>
+#include <QDate>
+#include <QFile>
+#include <QMap>
+#include <QPair>
+
+// 整个壁纸存档(2010-01-01至今)的二进制索引文件，通过内存映射打开
+// 文件结构: Header | DayRecord[dayCount] | 字符串表(UTF-8)
+// DayRecord按距2010-01-01的天数排列，查找任意日期只需一次指针计算，无需解析
+class ArchiveIndex
+{
+public:
+    explicit ArchiveIndex(const QString &filePath = QString());
+    ~ArchiveIndex();
+
+    static QDate firstDate() { return QDate(2010, 1, 1); }
+
+    bool lookup(const QDate &date, QString *imgtitle, QString *imgurl) const;
+    bool contains(const QDate &date) const;
+    int dayCount() const;
+
+    // 新增的记录先暂存在内存中，commit时与已有记录合并后整体重写索引文件
+    void insert(const QDate &date, const QString &imgtitle, const QString &imgurl);
+    bool hasPending() const { return !pending.isEmpty(); }
+    bool commit();
+
+private:
+    struct Header {
+        quint32 magic;
+        quint32 version;
+        quint32 firstDay;      // 第一条记录的儒略日
+        quint32 dayCount;
+        quint32 stringsOffset;
+        quint32 stringsSize;
+    };
+
+    struct DayRecord {
+        quint32 titleOffset;
+        quint32 titleLength;  // 为0表示该日期没有数据
+        quint32 urlOffset;
+        quint32 urlLength;
+    };
+
+    bool map();
+    void unmap();
+    const DayRecord *record(const QDate &date) const;
+
+    QFile file;
+    uchar *mapped = nullptr;
+    const Header *header = nullptr;
+    const DayRecord *records = nullptr;
+    const char *strings = nullptr;
+    QMap<qint64, QPair<QString, QString>> pending; // 键为儒略日
+};
+
+#endif // ARCHIVEINDEX_H
@@ -0,0 +1,263 @@
+#include "archivesync.h"
+#include "wallpaperfetcher.h"
+#include "rangeddownload.h"
+#include "imagestore.h"
+#include "imageexecutor.h"
+#include "imageindexer.h"
+#include "previewdecoder.h"
+#include "perceptualindex.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <cstdio>
+#include <optional>
+#include <utility>
+
+ArchiveSync::ArchiveSync(WallpaperFetcher *fetcher, QObject *parent)
+    : QObject(parent)
+    , fetcher(fetcher)
+    , manager(fetcher->network())
+    , executor(new ImageExecutor(this))
+    , indexer(new ImageIndexer(fetcher, executor, this))
+{
+    reportTimer.setInterval(1000);
+    connect(&reportTimer, &QTimer::timeout, this, [this]() {
+        report(false);
+    });
+    connect(indexer, &ImageIndexer::finished, this, &ArchiveSync::checkFinished);
+}
+
+void ArchiveSync::setRange(const QDate &from, const QDate &to)
+{
+    fromDate = qMax(from, ArchiveIndex::firstDate());
+    toDate = qMin(to, QDate::currentDate());
+}
+
+void ArchiveSync::setMaxConnections(int count)
+{
+    maxConnections = qMax(1, count);
+}
+
+void ArchiveSync::setMaxPerHost(int count)
+{
+    maxPerHost = qMax(1, count);
+}
+
+void ArchiveSync::setMaxRetries(int count)
+{
+    maxRetries = qMax(0, count);
+}
+
+void ArchiveSync::setOutputDir(const QString &dir)
+{
+    outputDir = dir;
+    if (!outputDir.isEmpty()) {
+        QDir().mkpath(outputDir);
+    }
+}
+
+void ArchiveSync::start()
+{
+    elapsed.start();
+
+    // 先补全存档索引，之后每个日期的url都可以直接查到
+    connect(fetcher, &WallpaperFetcher::archiveIndexBuilt, this, [this]() {
+        enqueueRange();
+        reportTimer.start();
+        schedule();
+    }, Qt::SingleShotConnection);
+    fetcher->buildArchiveIndex();
+}
+
+void ArchiveSync::enqueueRange()
+{
+    QHash<QString, qsizetype> queuedUrls;
+    for (QDate date = fromDate; date <= toDate; date = date.addDays(1)) {
+        QString imgtitle, imgurl;
+        if (!fetcher->cachedMetadata(date.toString("yyyyMMdd"), &imgtitle, &imgurl)) {
+            missingCount++;
+            continue;
+        }
+        totalCount++;
+
+        // 已存储的图片(包括记为别名的重复图片)跳过下载
+        QString storedPath = fetcher->imageStore()->find(imgurl);
+        if (storedPath.isEmpty()) {
+            storedPath = fetcher->imageStore()->findAlias(imgurl);
+        }
+        if (!storedPath.isEmpty()) {
+            skippedCount++;
+            jobDone(Job{date, imgurl, 0}, storedPath);
+            continue;
+        }
+        auto queued = queuedUrls.constFind(imgurl);
+        if (queued != queuedUrls.constEnd()) {
+            queue[*queued].sameImageDates.append(date);
+            continue;
+        }
+        queuedUrls.insert(imgurl, queue.size());
+        queue.append(Job{date, imgurl, 0});
+    }
+}
+
+void ArchiveSync::schedule()
+{
+    // 按顺序取出所在主机未达到并发上限的任务
+    for (int i = 0; i < queue.size() && active < maxConnections; ) {
+        QString host = QUrl(queue.at(i).imgurl).host();
+        if (activePerHost.value(host) >= maxPerHost) {
+            ++i;
+            continue;
+        }
+        startJob(queue.takeAt(i));
+    }
+    checkFinished();
+}
+
+void ArchiveSync::startJob(const Job &job)
+{
+    QString host = QUrl(job.imgurl).host();
+    active++;
+    activePerHost[host]++;
+
+    // 没有小尺寸预览的来源或重试时直接下载原图
+    if (job.attempts > 0 || WallpaperFetcher::previewUrl(job.imgurl) == QUrl(job.imgurl)) {
+        startDownload(job);
+        return;
+    }
+    QNetworkReply *reply = fetcher->warmPreview(job.imgurl);
+    if (!reply) {
+        checkDuplicate(job);
+        return;
+    }
+    // warmPreview先连接finished，这里执行时预览图已写入缓存
+    connect(reply, &QNetworkReply::finished, this, [this, job]() {
+        checkDuplicate(job);
+    });
+}
+
+void ArchiveSync::checkDuplicate(const Job &job)
+{
+    QByteArray data = fetcher->previewCache()->data(job.imgurl);
+    if (data.isEmpty()) {
+        startDownload(job);
+        return;
+    }
+
+    // 同时返回缩放后的尺寸，用于比较宽高比
+    using PreviewFeatures = std::optional<std::pair<quint64, QSize>>;
+    executor->run<PreviewFeatures>(ImageExecutor::ForegroundPriority, this, [data]() {
+        QImage image = PreviewDecoder::decodeScaled(data, QSize(64, 64));
+        return image.isNull() ? PreviewFeatures() : std::make_pair(PerceptualIndex::imageHash(image), image.size());
+    }, [this, job](PreviewFeatures features) {
+        QString storedPath = features ? fetcher->storedDuplicate(job.imgurl, features->first, features->second) : QString();
+        if (storedPath.isEmpty()) {
+            startDownload(job);
+            return;
+        }
+        releaseSlot(job);
+        duplicateCount++;
+        jobDone(job, storedPath);
+        schedule();
+    });
+}
+
+void ArchiveSync::startDownload(const Job &job)
+{
+    ImageStore *store = fetcher->imageStore();
+    QString filePath = store->incomingPath(job.imgurl);
+    RangedDownload *download = new RangedDownload(manager, QUrl(job.imgurl), filePath, this);
+    download->setStallTimeout(15000);
+
+    auto release = [this, job, download]() {
+        releaseSlot(job);
+        download->deleteLater();
+    };
+    connect(download, &RangedDownload::finished, this, [this, job, filePath, store, release]() {
+        release();
+        QString storedPath = store->add(job.imgurl, filePath);
+        if (storedPath.isEmpty()) {
+            jobFailed(job, tr("无法写入存储"));
+        } else {
+            downloadedBytes += QFileInfo(storedPath).size();
+            jobDone(job, storedPath);
+        }
+        schedule();
+    });
+    connect(download, &RangedDownload::failed, this,
+            [this, job, release](RangedDownload::Error, const QString &errorString) {
+        release();
+        jobFailed(job, errorString);
+        schedule();
+    });
+    download->start();
+}
+
+void ArchiveSync::releaseSlot(const Job &job)
+{
+    active--;
+    activePerHost[QUrl(job.imgurl).host()]--;
+}
+
+void ArchiveSync::jobDone(const Job &job, const QString &storedPath)
+{
+    const QList<QDate> dates = QList<QDate>{job.date} + job.sameImageDates;
+    for (const QDate &date : dates) {
+        doneCount++;
+        // 同时建立图片特征索引，之后的重复检测、相似查找和按颜色浏览都能用到
+        if (!indexer->isIndexed(date)) {
+            indexer->add(date, storedPath);
+        }
+        if (!outputDir.isEmpty()) {
+            QString destPath = QDir(outputDir).filePath(date.toString("yyyy-MM-dd") + ".jpg");
+            ImageStore::place(storedPath, destPath);
+        }
+    }
+}
+
+void ArchiveSync::jobFailed(Job job, const QString &errorString)
+{
+    job.attempts++;
+    if (job.attempts > maxRetries) {
+        failedCount += 1 + int(job.sameImageDates.size());
+        std::printf("%s failed: %s\n", qPrintable(job.date.toString("yyyy-MM-dd")), qPrintable(errorString));
+        for (const QDate &date : std::as_const(job.sameImageDates)) {
+            std::printf("%s failed: same image as %s\n", qPrintable(date.toString("yyyy-MM-dd")),
+                        qPrintable(job.date.toString("yyyy-MM-dd")));
+        }
+        return;
+    }
+
+    // 指数退避: 1s, 2s, 4s ... 最长30s；限制移位数，重试次数很大时不会溢出
+    int delay = qMin(30000, 1000 << qMin(job.attempts - 1, 5));
+    retrying++;
+    QTimer::singleShot(delay, this, [this, job]() {
+        retrying--;
+        queue.prepend(job);
+        schedule();
+    });
+}
+
+void ArchiveSync::checkFinished()
+{
+    if (!reportTimer.isActive() || !queue.isEmpty() || active > 0 || retrying > 0 || !indexer->isIdle()) {
+        return;
+    }
+    reportTimer.stop();
+    report(true);
+    emit finished(failedCount);
+}
+
+void ArchiveSync::report(bool final)
+{
+    double seconds = qMax<qint64>(1, elapsed.elapsed()) / 1000.0;
+    int downloaded = doneCount - skippedCount - duplicateCount;
+    std::printf("%s%d/%d done (%d skipped, %d duplicates, %d failed, %d without data)  %.2f images/s  %.2f MB/s\n",
+                final ? "finished: " : "",
+                doneCount, totalCount, skippedCount, duplicateCount, failedCount, missingCount,
+                downloaded / seconds, downloadedBytes / seconds / (1024 * 1024));
+    if (final) {
+        std::printf("%s\n", qPrintable(fetcher->network()->statsSummary()));
+    }
+    std::fflush(stdout);
+}
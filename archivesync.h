@@ -0,0 +1,86 @@
+#ifndef ARCHIVESYNC_H
+#define ARCHIVESYNC_H
+
+#include <QObject>
+#include <QDate>
+#include <QList>
+#include <QHash>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QtNetwork/QNetworkAccessManager>
+
+class WallpaperFetcher;
+class ImageExecutor;
+class ImageIndexer;
+
+// 无界面批量同步一段日期的原图到本地存储
+// 下载在连接池中进行，总并发数和每个主机的并发数都有上限；失败后按指数退避重试；
+// 已存储的图片直接跳过，中断后再次运行会从分段文件续传未完成的图片；
+// 下载原图前先比较预览图的感知哈希，与已存储的图片重复(重新发布)时不再下载
+class ArchiveSync : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ArchiveSync(WallpaperFetcher *fetcher, QObject *parent = nullptr);
+
+    void setRange(const QDate &from, const QDate &to);
+    void setMaxConnections(int count);
+    void setMaxPerHost(int count);
+    void setMaxRetries(int count);
+    // 同时以yyyy-MM-dd.jpg链接到该目录(不复制数据)，为空时只保存在存储中
+    void setOutputDir(const QString &dir);
+
+    void start();
+
+signals:
+    void finished(int failedCount);
+
+private:
+    struct Job {
+        QDate date;
+        QString imgurl;
+        int attempts = 0;
+        // 同一张图片在其他日期重新发布时只下载一次，完成后一并处理；
+        // 否则两个任务会写入同一个分段文件
+        QList<QDate> sameImageDates;
+    };
+
+    void enqueueRange();
+    void schedule();
+    void startJob(const Job &job);
+    void checkDuplicate(const Job &job);
+    void startDownload(const Job &job);
+    void releaseSlot(const Job &job);
+    void jobDone(const Job &job, const QString &storedPath);
+    void jobFailed(Job job, const QString &errorString);
+    void checkFinished();
+    void report(bool final);
+
+    WallpaperFetcher *fetcher;
+    QNetworkAccessManager *manager;
+    ImageExecutor *executor;
+    ImageIndexer *indexer;
+    QDate fromDate;
+    QDate toDate;
+    QString outputDir;
+    int maxConnections = 8;
+    int maxPerHost = 4;
+    int maxRetries = 4;
+
+    QList<Job> queue;
+    QHash<QString, int> activePerHost;
+    int active = 0;
+    int retrying = 0;
+    int totalCount = 0;
+    int doneCount = 0;
+    int skippedCount = 0;
+    int duplicateCount = 0;
+    int missingCount = 0;
+    int failedCount = 0;
+    qint64 downloadedBytes = 0;
+    QElapsedTimer elapsed;
+    QTimer reportTimer;
+};
+
+#endif // ARCHIVESYNC_H
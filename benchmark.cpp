@@ -0,0 +1,897 @@
+#include "benchmark.h"
+#include "metadataindex.h"
+#include "rangeddownload.h"
+#include "benchserver.h"
+#include "previewdecoder.h"
+#include "imageexecutor.h"
+#include "resampler.h"
+#include "perceptualindex.h"
+#include "colorindex.h"
+#include "titleindex.h"
+#include "thumbnailatlas.h"
+#include "wallpaperfetcher.h"
+#include "platform.h"
+#include "wallpaperrenderer.h"
+
+#include <QDir>
+#include <QDate>
+#include <QFile>
+#include <QFileInfo>
+#include <QEventLoop>
+#include <QTimer>
+#include <QSet>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QImage>
+#include <QBuffer>
+#include <QImageReader>
+#include <QPainter>
+#include <QStandardPaths>
+#include <QtMath>
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+
+namespace {
+
+void printResult(const char *name, qint64 nsecs, int iterations)
+{
+    std::printf("  %-36s %12.1f ns/op\n", name, double(nsecs) / iterations);
+}
+
+// 生成与服务器格式一致的月度json
+QByteArray makeMonthJson(const QString &yearMonth,
+                         const QString &imgurlFormat = "https://cn.bing.com/th?id=OHR.Sample%1_ZH-CN0000000000_UHD.jpg&rf=LaDigue_UHD.jpg&pid=hp")
+{
+    QDate firstDay = QDate::fromString(yearMonth + "01", "yyyyMMdd");
+    QJsonObject monthObj;
+    for (int day = 0; day < firstDay.daysInMonth(); ++day) {
+        QString date = firstDay.addDays(day).toString("yyyyMMdd");
+        QJsonObject dayObj;
+        dayObj["imgtitle"] = QString("示例壁纸标题 Sample wallpaper title %1").arg(date);
+        dayObj["imgurl"] = imgurlFormat.arg(date);
+        monthObj[date] = dayObj;
+    }
+    return QJsonDocument(monthObj).toJson(QJsonDocument::Compact);
+}
+
+void benchMetadataLookup()
+{
+    const QString yearMonth = "202401";
+    const QByteArray jsonData = makeMonthJson(yearMonth);
+    QStringList dates;
+    for (int day = 1; day <= 31; ++day) {
+        dates.append(yearMonth + QString::number(day).rightJustified(2, '0'));
+    }
+
+    QElapsedTimer timer;
+    qsizetype sink = 0;
+
+    // 旧方式：每次点击都解析整个月度文件再查找
+    const int parseIterations = 2000;
+    timer.start();
+    for (int i = 0; i < parseIterations; ++i) {
+        const QString &date = dates.at(i % dates.size());
+        QJsonObject monthObj = QJsonDocument::fromJson(jsonData).object();
+        if (monthObj.contains(date)) {
+            QJsonObject dayObj = monthObj[date].toObject();
+            sink += dayObj["imgurl"].toString().size();
+        }
+    }
+    printResult("fromJson + contains + toObject", timer.nsecsElapsed(), parseIterations);
+
+    // 新方式：解析一次，之后按日下标查找
+    MetadataIndex index;
+    timer.restart();
+    index.addMonth(yearMonth, jsonData);
+    printResult("MetadataIndex::addMonth (once)", timer.nsecsElapsed(), 1);
+
+    const int lookupIterations = 1000000;
+    QString imgtitle, imgurl;
+    timer.restart();
+    for (int i = 0; i < lookupIterations; ++i) {
+        if (index.lookup(dates.at(i % dates.size()), &imgtitle, &imgurl) == MetadataIndex::Found) {
+            sink += imgurl.size();
+        }
+    }
+    printResult("MetadataIndex::lookup", timer.nsecsElapsed(), lookupIterations);
+
+    std::printf("  (checksum %lld)\n", static_cast<long long>(sink));
+}
+
+// 下载一次，返回耗时(毫秒)；abortAtBytes>0时收到这么多数据后中止，模拟中断
+qint64 runDownload(QNetworkAccessManager *manager, const QUrl &url, const QString &filePath,
+                   int segments, qint64 abortAtBytes = -1)
+{
+    RangedDownload download(manager, url, filePath);
+    download.setMaxSegments(segments);
+    download.setMinSegmentSize(256 * 1024);
+    download.setStallTimeout(60000);
+
+    QEventLoop loop;
+    bool ok = false;
+    QObject::connect(&download, &RangedDownload::finished, &loop, [&]() {
+        ok = true;
+        loop.quit();
+    });
+    QObject::connect(&download, &RangedDownload::failed, &loop, &QEventLoop::quit);
+    QObject::connect(&download, &RangedDownload::progress, &loop, [&](qint64 received, qint64) {
+        if (abortAtBytes > 0 && received >= abortAtBytes) {
+            download.abort();
+            loop.quit();
+        }
+    });
+
+    QElapsedTimer timer;
+    timer.start();
+    download.start();
+    loop.exec();
+    return ok ? timer.elapsed() : -1;
+}
+
+void benchRangedDownload()
+{
+    BenchServer server;
+    server.listen(QHostAddress::LocalHost);
+
+    // 与UHD壁纸大小相近的随机数据
+    QByteArray image(4 * 1024 * 1024, Qt::Uninitialized);
+    QRandomGenerator::global()->fillRange(reinterpret_cast<quint32 *>(image.data()), image.size() / 4);
+    server.addResource("/uhd.jpg", image, "image/jpeg");
+
+    QNetworkAccessManager manager;
+    QString filePath = QDir::tempPath() + "/mybingwallpaper-bench.jpg";
+    auto cleanUp = [&filePath]() {
+        QFile::remove(filePath);
+        const QStringList parts = QDir::temp().entryList({"mybingwallpaper-bench-*.part*"}, QDir::Files);
+        for (const QString &part : parts) {
+            QFile::remove(QDir::temp().filePath(part));
+        }
+    };
+    auto verify = [&filePath, &image]() {
+        QFile file(filePath);
+        return file.open(QIODevice::ReadOnly) && file.readAll() == image;
+    };
+
+    const BenchServer::Profile profiles[] = {
+        {"local", 0, 0},
+        {"broadband 20ms 4MB/s", 20, 4 * 1024 * 1024},
+        {"dsl 60ms 1MB/s", 60, 1024 * 1024},
+        {"mobile 150ms 512KB/s", 150, 512 * 1024},
+    };
+
+    for (const BenchServer::Profile &profile : profiles) {
+        server.setProfile(profile);
+        std::printf("  %s\n", profile.name);
+        for (int segments : {1, 2, 4}) {
+            cleanUp();
+            qint64 elapsed = runDownload(&manager, server.url("/uhd.jpg"), filePath, segments);
+            double seconds = qMax<qint64>(1, elapsed) / 1000.0;
+            std::printf("    %d segment(s): %8lld ms  %6.2f MB/s  %s\n", segments,
+                        static_cast<long long>(elapsed), image.size() / seconds / (1024 * 1024),
+                        elapsed >= 0 && verify() ? "ok" : "FAILED");
+        }
+    }
+
+    // 中断后续传：只需下载剩余部分
+    server.setProfile(profiles[2]);
+    cleanUp();
+    runDownload(&manager, server.url("/uhd.jpg"), filePath, 1, image.size() / 2);
+    qint64 resumed = runDownload(&manager, server.url("/uhd.jpg"), filePath, 1);
+    std::printf("  resume after 50%% (%s): %lld ms  %s\n", profiles[2].name,
+                static_cast<long long>(resumed), resumed >= 0 && verify() ? "ok" : "FAILED");
+    cleanUp();
+}
+
+// 生成带渐变和噪声的JPEG，压缩后的大小接近真实照片
+QByteArray makeJpeg(int width, int height)
+{
+    QImage image(width, height, QImage::Format_RGB32);
+    QRandomGenerator random(width);
+    for (int y = 0; y < height; ++y) {
+        QRgb *line = reinterpret_cast<QRgb *>(image.scanLine(y));
+        for (int x = 0; x < width; ++x) {
+            int noise = int(random.bounded(32));
+            line[x] = qRgb((x * 255 / width + noise) & 0xff, (y * 255 / height + noise) & 0xff, ((x + y) / 8 + noise) & 0xff);
+        }
+    }
+    QByteArray data;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::WriteOnly);
+    image.save(&buffer, "JPEG", 90);
+    return data;
+}
+
+void benchPreviewDecode()
+{
+    // 主界面预览区域的大小
+    const QSize target(400, 225);
+    const struct {
+        const char *name;
+        int width;
+        int height;
+        int iterations;
+    } sources[] = {
+        {"480p", 854, 480, 100},
+        {"1080p", 1920, 1080, 30},
+        {"UHD", 3840, 2160, 10},
+    };
+
+    for (const auto &source : sources) {
+        QByteArray data = makeJpeg(source.width, source.height);
+        std::printf("  %s (%lld KB)\n", source.name, static_cast<long long>(data.size() / 1024));
+
+        QElapsedTimer timer;
+        qint64 sink = 0;
+
+        // 旧方式：完整解码后平滑缩放
+        timer.start();
+        for (int i = 0; i < source.iterations; ++i) {
+            QImage image;
+            image.loadFromData(data);
+            sink += image.scaled(target, Qt::KeepAspectRatio, Qt::SmoothTransformation).width();
+        }
+        std::printf("    %-34s %10.2f ms/op\n", "loadFromData + scaled(Smooth)",
+                    timer.nsecsElapsed() / 1e6 / source.iterations);
+
+        // 新方式：解码时缩放
+        timer.restart();
+        for (int i = 0; i < source.iterations; ++i) {
+            sink += PreviewDecoder::decodeScaled(data, target).width();
+        }
+        std::printf("    %-34s %10.2f ms/op\n", "PreviewDecoder::decodeScaled",
+                    timer.nsecsElapsed() / 1e6 / source.iterations);
+        std::printf("    (checksum %lld)\n", static_cast<long long>(sink));
+    }
+}
+
+void benchImageExecutor()
+{
+    const QSize target(400, 225);
+    const QByteArray data = makeJpeg(1920, 1080);
+    const int batchSize = 200;
+
+    ImageExecutor executor;
+    QObject context;
+    std::printf("  %d threads\n", executor.maxThreads());
+
+    auto decodeTask = [data, target]() {
+        return PreviewDecoder::decodeScaled(data, target);
+    };
+    // 提交一个前台任务，返回从提交到结果送回的时间
+    auto foregroundLatency = [&]() -> qint64 {
+        QEventLoop loop;
+        QElapsedTimer timer;
+        qint64 elapsed = -1;
+        timer.start();
+        executor.run<QImage>(ImageExecutor::ForegroundPriority, &context, decodeTask, [&](QImage) {
+            elapsed = timer.elapsed();
+            loop.quit();
+        });
+        loop.exec();
+        return elapsed;
+    };
+
+    qint64 idle = foregroundLatency();
+
+    // 排入大量后台任务后再提交前台任务，前台任务应插到队首
+    QEventLoop batchLoop;
+    int remaining = batchSize;
+    QElapsedTimer batchTimer;
+    batchTimer.start();
+    for (int i = 0; i < batchSize; ++i) {
+        executor.run<QImage>(ImageExecutor::BackgroundPriority, &context, decodeTask, [&](QImage) {
+            if (--remaining == 0) {
+                batchLoop.quit();
+            }
+        });
+    }
+    qint64 loaded = foregroundLatency();
+    if (remaining > 0) {
+        batchLoop.exec();
+    }
+    qint64 batchMsecs = batchTimer.elapsed();
+
+    std::printf("  foreground preview, idle            %8lld ms\n", static_cast<long long>(idle));
+    std::printf("  foreground preview, %d queued      %8lld ms\n", batchSize, static_cast<long long>(loaded));
+    std::printf("  batch of %d 1080p previews         %8lld ms (%.1f images/s)\n", batchSize,
+                static_cast<long long>(batchMsecs), batchSize * 1000.0 / qMax<qint64>(1, batchMsecs));
+}
+
+// 两张同尺寸图片RGB通道的峰值信噪比(dB)
+double psnr(const QImage &a, const QImage &b)
+{
+    double squared = 0.0;
+    for (int y = 0; y < a.height(); ++y) {
+        const QRgb *la = reinterpret_cast<const QRgb *>(a.constScanLine(y));
+        const QRgb *lb = reinterpret_cast<const QRgb *>(b.constScanLine(y));
+        for (int x = 0; x < a.width(); ++x) {
+            const int dr = qRed(la[x]) - qRed(lb[x]);
+            const int dg = qGreen(la[x]) - qGreen(lb[x]);
+            const int db = qBlue(la[x]) - qBlue(lb[x]);
+            squared += dr * dr + dg * dg + db * db;
+        }
+    }
+    const double mse = squared / (3.0 * a.width() * a.height());
+    return mse > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / mse) : 99.0;
+}
+
+// 本地存储中已下载的壁纸原图；没有时用生成的UHD图片代替
+QList<QByteArray> benchFrames(int maxCount)
+{
+    QList<QByteArray> frames;
+    QDir store(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/store");
+    const QStringList files = store.entryList({"*.jpg"}, QDir::Files, QDir::Time);
+    for (const QString &name : files) {
+        QFile file(store.filePath(name));
+        if (frames.size() < maxCount && !name.startsWith("incoming-") && file.open(QIODevice::ReadOnly)) {
+            frames.append(file.readAll());
+        }
+    }
+    if (frames.isEmpty()) {
+        frames.append(makeJpeg(3840, 2160));
+    }
+    return frames;
+}
+
+void benchResampler()
+{
+    const QList<QByteArray> frames = benchFrames(4);
+    std::printf("  %lld frame(s), best isa %s\n", static_cast<long long>(frames.size()),
+                Resampler::isaName(Resampler::bestIsa()));
+
+    const QSize targets[] = {QSize(400, 225), QSize(1920, 1080), QSize(2560, 1440)};
+    const int iterations = 5;
+    QImage source = QImage::fromData(frames.first()).convertToFormat(QImage::Format_RGB32);
+    std::printf("  source %dx%d\n", source.width(), source.height());
+
+    // 每种缩放方式：耗时、输入吞吐量，以及缩小再放大回原尺寸后与原图的PSNR
+    for (const QSize &target : targets) {
+        const QSize size = source.size().scaled(target, Qt::KeepAspectRatio);
+        const double megapixels = source.width() * double(source.height()) / 1e6;
+        std::printf("  -> %dx%d\n", size.width(), size.height());
+
+        auto report = [&](const char *name, const std::function<QImage(const QImage &, const QSize &)> &scale) {
+            QElapsedTimer timer;
+            QImage result;
+            timer.start();
+            for (int i = 0; i < iterations; ++i) {
+                result = scale(source, size);
+            }
+            const double msecs = timer.nsecsElapsed() / 1e6 / iterations;
+            const double quality = psnr(source, scale(result, source.size()));
+            std::printf("    %-26s %8.2f ms/op %8.1f MP/s  round-trip PSNR %6.2f dB\n", name, msecs,
+                        megapixels / msecs * 1000.0, quality);
+            return result;
+        };
+
+        report("QImage::scaled(Smooth)", [](const QImage &image, const QSize &to) {
+            return image.scaled(to, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+        });
+        QImage scalar;
+        for (int isa = Resampler::ScalarIsa; isa <= Resampler::bestIsa(); ++isa) {
+            for (Resampler::Filter filter : {Resampler::Bicubic, Resampler::Lanczos3}) {
+                QByteArray name = QByteArray("Resampler ") + Resampler::isaName(Resampler::Isa(isa))
+                                  + (filter == Resampler::Lanczos3 ? " lanczos3" : " bicubic");
+                QImage result = report(name.constData(), [filter, isa](const QImage &image, const QSize &to) {
+                    return Resampler::scaled(image, to, filter, Resampler::Isa(isa));
+                });
+                // 各实现的结果应与标量实现逐字节相同
+                if (filter == Resampler::Lanczos3) {
+                    if (isa == Resampler::ScalarIsa) {
+                        scalar = result;
+                    } else if (result != scalar) {
+                        std::printf("    %s differs from scalar\n", name.constData());
+                    }
+                }
+            }
+        }
+    }
+
+    // 批量生成预览：旧方式由Qt在DCT缩小后平滑缩放，新方式为PreviewDecoder::decodeScaled
+    const QSize preview(400, 225);
+    const int rounds = 20;
+    qint64 sink = 0;
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < rounds; ++i) {
+        for (const QByteArray &frame : frames) {
+            QBuffer buffer;
+            buffer.setData(frame);
+            buffer.open(QIODevice::ReadOnly);
+            QImageReader reader(&buffer);
+            reader.setScaledSize(reader.size().scaled(preview, Qt::KeepAspectRatio));
+            reader.setQuality(100);
+            sink += reader.read().width();
+        }
+    }
+    const double oldRate = rounds * frames.size() * 1e9 / qMax<qint64>(1, timer.nsecsElapsed());
+    timer.restart();
+    for (int i = 0; i < rounds; ++i) {
+        for (const QByteArray &frame : frames) {
+            sink += PreviewDecoder::decodeScaled(frame, preview).width();
+        }
+    }
+    const double newRate = rounds * frames.size() * 1e9 / qMax<qint64>(1, timer.nsecsElapsed());
+    std::printf("  bulk previews: setScaledSize(Smooth) %.1f images/s, decodeScaled %.1f images/s\n", oldRate, newRate);
+    std::printf("  (checksum %lld)\n", static_cast<long long>(sink));
+}
+
+void benchPerceptualIndex()
+{
+    // 计算哈希：从UHD原图按1/8解码后缩小
+    const QList<QByteArray> frames = benchFrames(4);
+    const int rounds = 10;
+    QElapsedTimer timer;
+    quint64 sink = 0;
+    timer.start();
+    for (int i = 0; i < rounds; ++i) {
+        for (const QByteArray &frame : frames) {
+            sink ^= PerceptualIndex::imageHash(PreviewDecoder::decodeScaled(frame, QSize(64, 64)));
+        }
+    }
+    std::printf("  hash from original: %.2f ms/image\n", timer.nsecsElapsed() / 1e6 / (rounds * frames.size()));
+
+    // 查询：随机哈希组成的索引，数量为现有存档和十倍存档
+    for (int count : {6000, 60000}) {
+        QString path = QDir::temp().filePath("mybingwallpaper-bench-phash.idx");
+        QFile::remove(path);
+        PerceptualIndex index(path);
+        QRandomGenerator random(count);
+        for (int i = 0; i < count; ++i) {
+            index.insert(QDate(2010, 1, 1).addDays(i), random.generate64());
+        }
+
+        const int queries = 1000;
+        qsizetype matches = 0;
+        timer.restart();
+        for (int i = 0; i < queries; ++i) {
+            matches += index.similar(random.generate64(), PerceptualIndex::SimilarDistance, 10).size();
+        }
+        std::printf("  similar() over %d hashes: %8.1f us/query (%lld matches)\n", count,
+                    timer.nsecsElapsed() / 1e3 / queries, static_cast<long long>(matches));
+        QFile::remove(path);
+    }
+    std::printf("  (checksum %llu)\n", static_cast<unsigned long long>(sink));
+}
+
+void benchColorIndex()
+{
+    // 颜色特征与感知哈希从同一张缩略图计算
+    const QList<QByteArray> frames = benchFrames(4);
+    QList<QImage> thumbnails;
+    for (const QByteArray &frame : frames) {
+        thumbnails.append(PreviewDecoder::decodeScaled(frame, QSize(64, 64)));
+    }
+    const int rounds = 200;
+    QElapsedTimer timer;
+    int sink = 0;
+    timer.start();
+    for (int i = 0; i < rounds; ++i) {
+        for (const QImage &thumbnail : std::as_const(thumbnails)) {
+            sink += ColorIndex::imageSignature(thumbnail).histogram[0];
+        }
+    }
+    std::printf("  signature from thumbnail: %.1f us/image\n", timer.nsecsElapsed() / 1e3 / (rounds * thumbnails.size()));
+
+    // 查询：随机生成的图片特征，数量为现有存档和十倍存档
+    for (int count : {6000, 60000}) {
+        QString path = QDir::temp().filePath("mybingwallpaper-bench-color.idx");
+        QFile::remove(path);
+        ColorIndex index(path);
+        QRandomGenerator random(count);
+        QImage image(16, 9, QImage::Format_RGB32);
+        for (int i = 0; i < count; ++i) {
+            image.fill(QColor::fromRgb(random.generate()));
+            for (int k = 0; k < 40; ++k) {
+                image.setPixel(random.bounded(16), random.bounded(9), random.generate());
+            }
+            index.insert(QDate(2010, 1, 1).addDays(i), ColorIndex::imageSignature(image));
+        }
+
+        const int queries = 200;
+        timer.restart();
+        for (int i = 0; i < queries; ++i) {
+            sink += index.nearest(QColor::fromRgb(random.generate()), 12).size();
+        }
+        std::printf("  nearest() top-12 over %d images: %8.3f ms/query\n", count, timer.nsecsElapsed() / 1e6 / queries);
+        QFile::remove(path);
+    }
+    std::printf("  (checksum %d)\n", sink);
+}
+
+void benchTitleIndex()
+{
+    // 中英混合的随机标题，格式接近真实数据
+    const QStringList chinese = {"长城", "日落", "雪山", "湖泊", "森林", "海岸", "极光", "沙漠", "瀑布", "古镇",
+                                 "樱花", "秋叶", "星空", "峡谷", "草原", "冰川", "灯塔", "岛屿", "火山", "梯田"};
+    const QStringList english = {"Great", "Wall", "sunset", "mountain", "lake", "forest", "coast", "aurora",
+                                 "desert", "waterfall", "Kyoto", "cherry", "autumn", "canyon", "glacier",
+                                 "lighthouse", "island", "volcano", "Yunnan", "Patagonia", "Norway", "Iceland"};
+    const QStringList typed = {"长城日落", "冰川 Norway", "lighthouse", "瀑布 aut"};
+
+    for (int count : {6000, 60000}) {
+        QString path = QDir::temp().filePath("mybingwallpaper-bench-titles.idx");
+        QFile::remove(path);
+        QRandomGenerator random(count);
+        QElapsedTimer timer;
+        {
+            TitleIndex index(path);
+            timer.start();
+            for (int i = 0; i < count; ++i) {
+                QString title = chinese.at(random.bounded(chinese.size())) + "的" + chinese.at(random.bounded(chinese.size()))
+                    + "（" + english.at(random.bounded(english.size())) + " "
+                    + english.at(random.bounded(english.size())) + ", " + english.at(random.bounded(english.size()))
+                    + "）";
+                index.insert(QDate(2010, 1, 1).addDays(i), title);
+            }
+            std::printf("  insert %d titles: %8.1f ms\n", count, timer.nsecsElapsed() / 1e6);
+            timer.restart();
+            index.commit();
+            std::printf("  commit: %8.1f ms (%lld KB)\n", timer.nsecsElapsed() / 1e6,
+                        static_cast<long long>(QFileInfo(path).size() / 1024));
+        }
+
+        timer.restart();
+        TitleIndex index(path);
+        std::printf("  load: %8.1f ms\n", timer.nsecsElapsed() / 1e6);
+
+        // 逐字输入，每次按键都查询一次
+        qsizetype matches = 0;
+        int keystrokes = 0;
+        timer.restart();
+        for (const QString &query : typed) {
+            for (qsizetype length = 1; length <= query.size(); ++length) {
+                matches += index.search(query.left(length), 50).size();
+                keystrokes++;
+            }
+        }
+        std::printf("  search as you type over %d titles: %8.1f us/keystroke (%lld matches)\n", count,
+                    timer.nsecsElapsed() / 1e3 / keystrokes, static_cast<long long>(matches));
+        QFile::remove(path);
+    }
+}
+
+void benchThumbnailAtlas()
+{
+    // 模拟总览窗口从2010年滚动到今天：每帧画出可见的格子，缺少的缩略图当帧放入图集
+    const QSize cell(128, 72);
+    const int rowHeight = cell.height() + 4;
+    QImage viewport(64 + 7 * (cell.width() + 4), 700, QImage::Format_RGB32);
+    QList<QImage> thumbnails;
+    for (int i = 0; i < 8; ++i) {
+        QImage thumbnail(cell, QImage::Format_RGB32);
+        thumbnail.fill(QColor::fromHsv(i * 45, 160, 200));
+        thumbnails.append(thumbnail);
+    }
+
+    const int rows = int(QDate(2010, 1, 1).daysTo(QDate::currentDate()) / 7) + 1;
+    const int step = rowHeight / 2;
+    for (bool revisit : {false, true}) {
+        ThumbnailAtlas atlas(cell);
+        QList<qint64> frameTimes;
+        QElapsedTimer timer;
+        qint64 inserted = 0;
+        // revisit: 在相邻几年之间来回滚动，大部分缩略图已在图集中
+        const int range = revisit ? qMin(rows, 3 * 53) * rowHeight : rows * rowHeight;
+        for (int pass = 0; pass < (revisit ? 6 : 1); ++pass) {
+            for (int y = 0; y + viewport.height() < range; y += step) {
+                const int scroll = pass % 2 ? range - viewport.height() - y : y;
+                timer.start();
+                QPainter painter(&viewport);
+                painter.fillRect(viewport.rect(), Qt::darkGray);
+                for (int row = scroll / rowHeight; row <= (scroll + viewport.height()) / rowHeight; ++row) {
+                    for (int column = 0; column < 7; ++column) {
+                        const qint64 key = qint64(row) * 7 + column;
+                        const QRect rect(64 + column * (cell.width() + 4), row * rowHeight - scroll, cell.width(), cell.height());
+                        if (!atlas.draw(&painter, rect, key)) {
+                            atlas.insert(key, thumbnails.at(key % thumbnails.size()));
+                            atlas.draw(&painter, rect, key);
+                            inserted++;
+                        }
+                    }
+                }
+                painter.end();
+                frameTimes.append(timer.nsecsElapsed());
+            }
+        }
+        std::sort(frameTimes.begin(), frameTimes.end());
+        std::printf("  %-26s %6lld frames  p50 %6.3f ms  p99 %6.3f ms  %lld inserts  atlas %lld KB (capacity %d)\n",
+                    revisit ? "scroll back and forth:" : "scroll 2010 -> today:",
+                    static_cast<long long>(frameTimes.size()), frameTimes.at(frameTimes.size() / 2) / 1e6,
+                    frameTimes.at(frameTimes.size() * 99 / 100) / 1e6, static_cast<long long>(inserted),
+                    static_cast<long long>(atlas.memoryBytes() / 1024), atlas.capacity());
+    }
+}
+
+void benchFootprint()
+{
+    // 无界面部分的内存占用(以私有内存为准)：启动时读入的各索引，以及释放空闲内存后的效果
+    std::printf("  startup:             %s\n", qPrintable(processMemorySummary()));
+    {
+        WallpaperFetcher fetcher;
+        std::printf("  indexes loaded:      %s\n", qPrintable(processMemorySummary()));
+        trimProcessMemory();
+        std::printf("  after trim:          %s\n", qPrintable(processMemorySummary()));
+    }
+    trimProcessMemory();
+    std::printf("  fetcher destroyed:   %s\n", qPrintable(processMemorySummary()));
+}
+
+// 打印样本的p50/p99，样本单位为unit
+void printLatency(const char *name, QList<double> samples, int failed, const char *unit = "ms")
+{
+    if (samples.isEmpty()) {
+        std::printf("    %-30s no samples, %d failed\n", name, failed);
+        return;
+    }
+    std::sort(samples.begin(), samples.end());
+    const qsizetype last = samples.size() - 1;
+    std::printf("    %-30s n=%-4lld p50 %9.2f %s  p99 %9.2f %s  max %9.2f %s  %d failed\n", name,
+                static_cast<long long>(samples.size()), samples.at(last * 50 / 100), unit,
+                samples.at(last * 99 / 100), unit, samples.at(last), unit, failed);
+}
+
+// 测试模式下的数据和缓存目录，避免改动用户的存档和索引
+void clearTestData()
+{
+    for (QStandardPaths::StandardLocation location : {QStandardPaths::AppDataLocation, QStandardPaths::CacheLocation}) {
+        const QString path = QStandardPaths::writableLocation(location);
+        if (QStandardPaths::isTestModeEnabled() && path.contains("qttest")) {
+            QDir(path).removeRecursively();
+        }
+    }
+}
+
+void benchEndToEnd()
+{
+    // 本地服务器提供两年的月度json(两个镜像路径)、预览图和原图，
+    // imgurl带bing.com时按bing的方式以&w=480请求预览图
+    BenchServer server;
+    server.listen(QHostAddress::LocalHost);
+    const QDate firstDay(2019, 6, 1);
+    const QDate lastDay(2021, 5, 31);
+    const QString imgurlFormat = server.url("/th").toString() + "?id=OHR.Bench%1_UHD.jpg&rf=bing.com";
+    const QByteArray preview = makeJpeg(480, 270);
+    QList<QByteArray> originals;
+    for (int i = 0; i < 4; ++i) {
+        originals.append(makeJpeg(3840 - 8 * i, 2160));
+    }
+    for (QDate month = firstDay; month <= lastDay; month = month.addMonths(1)) {
+        const QString yearMonth = month.toString("yyyyMM");
+        const QByteArray json = makeMonthJson(yearMonth, imgurlFormat);
+        server.addResource("/a/month/" + yearMonth + ".json", json, "application/json");
+        server.addResource("/b/month/" + yearMonth + ".json", json, "application/json");
+    }
+    for (QDate date = firstDay; date <= lastDay; date = date.addDays(1)) {
+        const QString path = QUrl(imgurlFormat.arg(date.toString("yyyyMMdd"))).toString(QUrl::RemoveScheme | QUrl::RemoveAuthority);
+        server.addResource(path, originals.at(date.day() % originals.size()), "image/jpeg");
+        server.addResource(path + "&w=480", preview, "image/jpeg");
+    }
+    std::printf("  %lld days, original %lld KB, preview %lld KB\n", static_cast<long long>(firstDay.daysTo(lastDay) + 1),
+                static_cast<long long>(originals.first().size() / 1024), static_cast<long long>(preview.size() / 1024));
+
+    const BenchServer::Profile profiles[] = {
+        {"local", 0, 0},
+        {"broadband 20ms 4MB/s", 20, 4 * 1024 * 1024, 10},
+        {"flaky broadband, 5% 503, 2% resets", 20, 4 * 1024 * 1024, 10, 0.05, 0.02},
+    };
+
+    QStandardPaths::setTestModeEnabled(true);
+    for (const BenchServer::Profile &profile : profiles) {
+        server.setProfile(profile);
+        const int requestsBefore = server.requestCount();
+        const int errorsBefore = server.errorCount() + server.resetCount();
+        std::printf("  %s\n", profile.name);
+
+        // 每个网络条件从空的缓存和索引开始
+        clearTestData();
+        ImageExecutor executor;
+        PreviewDecoder decoder(&executor);
+        WallpaperFetcher fetcher;
+        fetcher.setMetadataMirrors({server.url("/a/").toString(), server.url("/b/").toString()});
+        QRandomGenerator random(profile.latencyMs);
+        auto randomDate = [&]() {
+            return firstDay.addDays(random.bounded(int(firstDay.daysTo(lastDay)) + 1));
+        };
+
+        // 点击日历到预览图显示：与主界面相同，原图已存储时从原图生成预览，否则获取预览图
+        QList<double> toMetadata, toPreview;
+        int clickFailed = 0;
+        QElapsedTimer timer;
+        for (int i = 0; i < 60; ++i) {
+            const QString date = randomDate().toString("yyyyMMdd");
+            QEventLoop loop;
+            QObject context;
+            bool ok = false;
+            bool done = false;
+            auto finish = [&](bool success) {
+                ok = success;
+                done = true;
+                loop.quit();
+            };
+            QObject::connect(&fetcher, &WallpaperFetcher::metadataReady, &context,
+                             [&](const QString &readyDate, const QString &, const QString &imgurl) {
+                if (readyDate != date) {
+                    return;
+                }
+                toMetadata.append(timer.nsecsElapsed() / 1e6);
+                const QString storedPath = fetcher.imageStore()->find(imgurl);
+                if (storedPath.isEmpty()) {
+                    fetcher.fetchPreview(imgurl);
+                } else {
+                    decoder.decodeFile(imgurl, storedPath, QSize(400, 225));
+                }
+            });
+            QObject::connect(&fetcher, &WallpaperFetcher::previewReady, &context,
+                             [&](const QString &imgurl, const QByteArray &data) {
+                decoder.decode(imgurl, data, QSize(400, 225));
+            });
+            QObject::connect(&decoder, &PreviewDecoder::decoded, &context, [&](const QString &, const QImage &image) {
+                finish(!image.isNull());
+            });
+            QObject::connect(&fetcher, &WallpaperFetcher::failed, &context, [&]() {
+                finish(false);
+            });
+            QTimer::singleShot(30000, &context, [&]() {
+                finish(false);
+            });
+            timer.start();
+            fetcher.fetchMetadata(date);
+            if (!done) {
+                loop.exec();
+            }
+            if (ok) {
+                toPreview.append(timer.nsecsElapsed() / 1e6);
+            } else {
+                clickFailed++;
+            }
+        }
+        printLatency("click -> metadata", toMetadata, clickFailed);
+        printLatency("click -> preview decoded", toPreview, clickFailed);
+
+        // 已收录月份的元数据查找，同步返回
+        QList<double> lookups;
+        {
+            QObject context;
+            QObject::connect(&fetcher, &WallpaperFetcher::metadataReady, &context, [&]() {
+                lookups.append(timer.nsecsElapsed() / 1e3);
+            });
+            for (int i = 0; i < 2000; ++i) {
+                QString imgtitle, imgurl;
+                const QString date = randomDate().toString("yyyyMMdd");
+                if (fetcher.cachedMetadata(date, &imgtitle, &imgurl)) {
+                    timer.start();
+                    fetcher.fetchMetadata(date);
+                }
+            }
+        }
+        printLatency("metadata lookup (indexed)", lookups, 0, "us");
+
+        // 原图下载：单张的耗时和总吞吐量
+        QList<double> downloads;
+        int downloadFailed = 0;
+        qint64 downloadedBytes = 0;
+        double downloadMsecs = 0.0;
+        auto fetchImage = [&](const QString &date, QString *storedPath) -> bool {
+            QEventLoop loop;
+            QObject context;
+            bool ok = false;
+            bool done = false;
+            auto finish = [&](bool success) {
+                ok = success;
+                done = true;
+                loop.quit();
+            };
+            QObject::connect(&fetcher, &WallpaperFetcher::metadataReady, &context,
+                             [&](const QString &readyDate, const QString &, const QString &imgurl) {
+                if (readyDate == date) {
+                    fetcher.fetchImage(imgurl);
+                }
+            });
+            QObject::connect(&fetcher, &WallpaperFetcher::imageReady, &context,
+                             [&](const QString &, const QString &filePath) {
+                *storedPath = filePath;
+                finish(true);
+            });
+            QObject::connect(&fetcher, &WallpaperFetcher::failed, &context,
+                             [&](WallpaperFetcher::Stage stage, const QString &) {
+                if (stage != WallpaperFetcher::PreviewStage) {
+                    finish(false);
+                }
+            });
+            QTimer::singleShot(60000, &context, [&]() {
+                finish(false);
+            });
+            fetcher.fetchMetadata(date);
+            if (!done) {
+                loop.exec();
+            }
+            return ok;
+        };
+        // 每次下载不同的日期，不命中已存储的原图
+        QSet<QDate> downloadedDates;
+        for (int i = 0; i < 8; ++i) {
+            QString storedPath;
+            QDate day = randomDate();
+            while (downloadedDates.contains(day)) {
+                day = randomDate();
+            }
+            downloadedDates.insert(day);
+            const QString date = day.toString("yyyyMMdd");
+            timer.start();
+            if (fetchImage(date, &storedPath)) {
+                const double msecs = timer.nsecsElapsed() / 1e6;
+                downloads.append(msecs);
+                downloadMsecs += msecs;
+                downloadedBytes += QFileInfo(storedPath).size();
+            } else {
+                downloadFailed++;
+            }
+        }
+        printLatency("full image download", downloads, downloadFailed);
+        std::printf("    %-30s %.2f MB/s\n", "download throughput",
+                    downloadedBytes / qMax(1.0, downloadMsecs) * 1000.0 / (1024 * 1024));
+
+        // 随机壁纸：随机日期的原图下载完成并生成显示器尺寸的壁纸
+        QList<double> randoms;
+        int randomFailed = 0;
+        WallpaperRenderer renderer;
+        for (int i = 0; i < 8; ++i) {
+            QString storedPath;
+            timer.start();
+            if (!fetchImage(randomDate().toString("yyyyMMdd"), &storedPath)) {
+                randomFailed++;
+                continue;
+            }
+            QEventLoop loop;
+            QObject context;
+            executor.run<QString>(ImageExecutor::ForegroundPriority, &context, [renderer, storedPath]() {
+                return renderer.render(storedPath, QSize(1920, 1080));
+            }, [&](QString) {
+                loop.quit();
+            });
+            loop.exec();
+            randoms.append(timer.nsecsElapsed() / 1e6);
+        }
+        printLatency("random wallpaper", randoms, randomFailed);
+        std::printf("    %d requests, %d injected errors\n", server.requestCount() - requestsBefore,
+                    server.errorCount() + server.resetCount() - errorsBefore);
+    }
+    clearTestData();
+    QStandardPaths::setTestModeEnabled(false);
+}
+
+struct Benchmark {
+    const char *name;
+    void (*run)();
+};
+
+const Benchmark benchmarks[] = {
+    {"metadata", benchMetadataLookup},
+    {"download", benchRangedDownload},
+    {"preview", benchPreviewDecode},
+    {"executor", benchImageExecutor},
+    {"resample", benchResampler},
+    {"phash", benchPerceptualIndex},
+    {"color", benchColorIndex},
+    {"titles", benchTitleIndex},
+    {"atlas", benchThumbnailAtlas},
+    {"footprint", benchFootprint},
+    {"e2e", benchEndToEnd},
+};
+
+} // namespace
+
+int runBenchmarks(const QStringList &names)
+{
+    for (const Benchmark &bench : benchmarks) {
+        if (names.isEmpty() || names.contains(QLatin1String(bench.name))) {
+            std::printf("== %s\n", bench.name);
+            bench.run();
+        }
+    }
+    return 0;
+}
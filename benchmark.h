@@ -0,0 +1,10 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <QStringList>
+
+// 性能测试，仅在 qmake CONFIG+=bench 时编译
+// 运行: mybingwallpaper --bench [名称...]，不指定名称时运行全部
+int runBenchmarks(const QStringList &names);
+
+#endif // BENCHMARK_H
@@ -0,0 +1,227 @@
+#include "benchserver.h"
+
+#include <QTcpSocket>
+#include <QTimer>
+#include <QCryptographicHash>
+
+// 一个客户端连接：逐个解析请求，按设定的延迟和带宽发送响应
+class BenchConnection : public QObject
+{
+public:
+    BenchConnection(BenchServer *server, QTcpSocket *socket)
+        : QObject(socket)
+        , server(server)
+        , socket(socket)
+    {
+        connect(socket, &QTcpSocket::readyRead, this, [this]() { processRequests(); });
+        connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+    }
+
+    ~BenchConnection() override
+    {
+        server->stopSending(this);
+    }
+
+    // 发送不超过budget字节，返回实际发送的字节数
+    qint64 sendChunk(qint64 budget)
+    {
+        qint64 chunk = qMin<qint64>(qMax<qint64>(1, budget), pending.size());
+        socket->write(pending.left(chunk));
+        pending.remove(0, chunk);
+        if (pending.isEmpty()) {
+            server->stopSending(this);
+            finishResponse();
+        }
+        return chunk;
+    }
+
+private:
+    void processRequests()
+    {
+        buffer += socket->readAll();
+        if (sending) {
+            return;
+        }
+
+        int headerEnd = buffer.indexOf("\r\n\r\n");
+        if (headerEnd < 0) {
+            return;
+        }
+        QByteArray head = buffer.left(headerEnd);
+        buffer.remove(0, headerEnd + 4);
+        server->requests++;
+
+        const QList<QByteArray> lines = head.split('\n');
+        const QList<QByteArray> requestLine = lines.first().trimmed().split(' ');
+        QByteArray method = requestLine.value(0);
+        QString path = QString::fromLatin1(requestLine.value(1));
+        QByteArray range;
+        QByteArray ifRange;
+        for (const QByteArray &line : lines) {
+            if (line.toLower().startsWith("range:")) {
+                range = line.mid(6).trimmed();
+            } else if (line.toLower().startsWith("if-range:")) {
+                ifRange = line.mid(9).trimmed();
+            }
+        }
+
+        sending = true;
+        const BenchServer::Profile &profile = server->profile;
+        QByteArray response = respond(method, path, range, ifRange);
+        closeAfterResponse = false;
+        const double roll = server->random.generateDouble();
+        if (roll < profile.errorRate) {
+            server->errors++;
+            response = "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\nConnection: keep-alive\r\n\r\n";
+        } else if (roll < profile.errorRate + profile.resetRate) {
+            server->resets++;
+            response.truncate(response.size() / 2);
+            closeAfterResponse = true;
+        }
+        int latency = profile.latencyMs + (profile.jitterMs > 0 ? int(server->random.bounded(profile.jitterMs + 1)) : 0);
+        QTimer::singleShot(latency, this, [this, response]() {
+            pending = response;
+            if (server->profile.bytesPerSecond <= 0) {
+                socket->write(pending);
+                pending.clear();
+                finishResponse();
+            } else {
+                server->startSending(this);
+            }
+        });
+    }
+
+    QByteArray respond(const QByteArray &method, const QString &path, const QByteArray &range,
+                       const QByteArray &ifRange)
+    {
+        auto it = server->resources.constFind(path);
+        if (it == server->resources.constEnd()) {
+            return "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: keep-alive\r\n\r\n";
+        }
+
+        const QByteArray &body = it->body;
+        qint64 total = body.size();
+        qint64 from = 0;
+        qint64 to = total - 1;
+        QByteArray status = "200 OK";
+        QByteArray extra;
+
+        // If-Range与当前ETag不同时忽略Range，返回完整文件
+        if (range.startsWith("bytes=") && (ifRange.isEmpty() || ifRange == it->etag)) {
+            QList<QByteArray> bounds = range.mid(6).split('-');
+            from = bounds.value(0).toLongLong();
+            if (!bounds.value(1).isEmpty()) {
+                to = qMin(total - 1, bounds.value(1).toLongLong());
+            }
+            if (from >= total || from > to) {
+                return "HTTP/1.1 416 Range Not Satisfiable\r\nContent-Range: bytes */"
+                    + QByteArray::number(total) + "\r\nContent-Length: 0\r\nConnection: keep-alive\r\n\r\n";
+            }
+            status = "206 Partial Content";
+            extra = "Content-Range: bytes " + QByteArray::number(from) + "-" + QByteArray::number(to)
+                + "/" + QByteArray::number(total) + "\r\n";
+        }
+
+        QByteArray response = "HTTP/1.1 " + status + "\r\n"
+            + "Content-Type: " + it->contentType + "\r\n"
+            + "Content-Length: " + QByteArray::number(to - from + 1) + "\r\n"
+            + "Accept-Ranges: bytes\r\n"
+            + "ETag: " + it->etag + "\r\n"
+            + "Connection: keep-alive\r\n"
+            + extra + "\r\n";
+        if (method != "HEAD") {
+            response += body.mid(from, to - from + 1);
+        }
+        return response;
+    }
+
+    void finishResponse()
+    {
+        if (closeAfterResponse) {
+            socket->disconnectFromHost();
+            return;
+        }
+        sending = false;
+        if (!buffer.isEmpty()) {
+            processRequests();
+        }
+    }
+
+    BenchServer *server;
+    QTcpSocket *socket;
+    QByteArray buffer;
+    QByteArray pending;
+    bool sending = false;
+    bool closeAfterResponse = false;
+};
+
+BenchServer::BenchServer(QObject *parent)
+    : QTcpServer(parent)
+{
+    pacer.setInterval(20);
+    connect(&pacer, &QTimer::timeout, this, &BenchServer::pace);
+}
+
+BenchServer::~BenchServer()
+{
+    // 连接析构时会访问sendingConnections，须在成员析构前释放
+    qDeleteAll(findChildren<QTcpSocket *>(Qt::FindDirectChildrenOnly));
+}
+
+void BenchServer::setProfile(const Profile &profile)
+{
+    this->profile = profile;
+}
+
+void BenchServer::addResource(const QString &path, const QByteArray &body, const QByteArray &contentType)
+{
+    QByteArray etag = '"' + QCryptographicHash::hash(body, QCryptographicHash::Sha1).toHex().left(16) + '"';
+    resources.insert(path, Resource{body, contentType, etag});
+}
+
+QUrl BenchServer::url(const QString &path) const
+{
+    return QUrl(QString("http://127.0.0.1:%1%2").arg(serverPort()).arg(path));
+}
+
+void BenchServer::incomingConnection(qintptr socketDescriptor)
+{
+    QTcpSocket *socket = new QTcpSocket(this);
+    if (!socket->setSocketDescriptor(socketDescriptor)) {
+        delete socket;
+        return;
+    }
+    new BenchConnection(this, socket);
+}
+
+void BenchServer::startSending(BenchConnection *connection)
+{
+    if (!sendingConnections.contains(connection)) {
+        sendingConnections.append(connection);
+    }
+    if (!pacer.isActive()) {
+        paceClock.start();
+        pacer.start();
+    }
+}
+
+void BenchServer::stopSending(BenchConnection *connection)
+{
+    sendingConnections.removeOne(connection);
+    if (sendingConnections.isEmpty()) {
+        pacer.stop();
+    }
+}
+
+void BenchServer::pace()
+{
+    // 带宽按实际经过的时间计算，由正在发送的连接平分；
+    // 分段下载开多个连接不会得到更多带宽，与真实网络的瓶颈一致
+    qint64 budget = profile.bytesPerSecond * paceClock.restart() / 1000;
+    // 发送完的连接会从列表中移除，遍历副本
+    const QList<BenchConnection *> connections = sendingConnections;
+    for (qsizetype i = 0; i < connections.size(); i++) {
+        // 前面的连接没用完的份额留给后面的连接
+        budget -= connections.at(i)->sendChunk(budget / (connections.size() - i));
+    }
+}
@@ -0,0 +1,71 @@
+#ifndef BENCHSERVER_H
+#define BENCHSERVER_H
+
+#include <QTcpServer>
+#include <QHash>
+#include <QString>
+#include <QByteArray>
+#include <QUrl>
+#include <QList>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+
+class BenchConnection;
+
+// 性能测试用的本地HTTP服务器，可模拟网络延迟、抖动、带宽和出错
+// 支持GET/HEAD、Range/If-Range请求和keep-alive，仅用于 CONFIG+=bench 构建
+class BenchServer : public QTcpServer
+{
+    Q_OBJECT
+
+public:
+    struct Profile {
+        const char *name = "local";
+        int latencyMs = 0;          // 每个请求返回首字节前的延迟
+        qint64 bytesPerSecond = 0;  // 所有连接共享的带宽，0为不限速
+        int jitterMs = 0;           // 延迟再随机增加0到jitterMs
+        double errorRate = 0.0;     // 以503响应的请求比例
+        double resetRate = 0.0;     // 只发送一半响应就断开连接的请求比例
+    };
+
+    explicit BenchServer(QObject *parent = nullptr);
+    ~BenchServer() override;
+
+    void setProfile(const Profile &profile);
+    const Profile &currentProfile() const { return profile; }
+    void addResource(const QString &path, const QByteArray &body, const QByteArray &contentType);
+    QUrl url(const QString &path) const;
+    int requestCount() const { return requests; }
+    int errorCount() const { return errors; }
+    int resetCount() const { return resets; }
+
+protected:
+    void incomingConnection(qintptr socketDescriptor) override;
+
+private:
+    friend class BenchConnection;
+
+    struct Resource {
+        QByteArray body;
+        QByteArray contentType;
+        QByteArray etag;
+    };
+
+    // 限速时正在发送的连接由服务器统一定时发送，平分带宽
+    void startSending(BenchConnection *connection);
+    void stopSending(BenchConnection *connection);
+    void pace();
+
+    QHash<QString, Resource> resources;
+    Profile profile;
+    QRandomGenerator random{2010};  // 固定种子，每次运行注入的错误相同
+    int requests = 0;
+    int errors = 0;
+    int resets = 0;
+    QList<BenchConnection *> sendingConnections;
+    QTimer pacer;
+    QElapsedTimer paceClock;
+};
+
+#endif // BENCHSERVER_H
@@ -0,0 +1,226 @@
+#include "colorindex.h"
+#include "cpufeatures.h"
+
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QtMath>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+const quint32 indexMagic = 0x4943424d; // "MBCI"
+const quint32 indexVersion = 1;
+
+// 颜色相似度的衰减距离，约为一个量化区间的宽度
+const double kernelWidth = 80.0;
+
+int binOf(QRgb rgb)
+{
+    return (qRed(rgb) >> 6) << 4 | (qGreen(rgb) >> 6) << 2 | (qBlue(rgb) >> 6);
+}
+
+// 按人眼敏感度加权的RGB距离(redmean)
+double colorDistance(QRgb a, QRgb b)
+{
+    const double meanRed = (qRed(a) + qRed(b)) / 2.0;
+    const int dr = qRed(a) - qRed(b);
+    const int dg = qGreen(a) - qGreen(b);
+    const int db = qBlue(a) - qBlue(b);
+    return std::sqrt((2.0 + meanRed / 256.0) * dr * dr + 4.0 * dg * dg + (2.0 + (255.0 - meanRed) / 256.0) * db * db) / 3.0;
+}
+
+// 0-256
+qint16 similarity(QRgb a, QRgb b)
+{
+    const double d = colorDistance(a, b) / kernelWidth;
+    return qint16(qRound(256.0 * std::exp(-d * d)));
+}
+
+int histogramScore(const quint8 *histogram, const qint16 *weights)
+{
+#if defined(Q_PROCESSOR_X86)
+    const __m128i zero = _mm_setzero_si128();
+    __m128i acc = zero;
+    for (int k = 0; k < ColorIndex::BinCount; k += 16) {
+        __m128i bins = _mm_loadu_si128(reinterpret_cast<const __m128i *>(histogram + k));
+        __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i *>(weights + k));
+        __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i *>(weights + k + 8));
+        acc = _mm_add_epi32(acc, _mm_madd_epi16(_mm_unpacklo_epi8(bins, zero), lo));
+        acc = _mm_add_epi32(acc, _mm_madd_epi16(_mm_unpackhi_epi8(bins, zero), hi));
+    }
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, 0x4e));
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, 0xb1));
+    return _mm_cvtsi128_si32(acc);
+#else
+    int sum = 0;
+    for (int k = 0; k < ColorIndex::BinCount; ++k) {
+        sum += histogram[k] * weights[k];
+    }
+    return sum;
+#endif
+}
+
+}
+
+ColorIndex::ColorIndex(const QString &filePath)
+    : filePath(filePath)
+{
+    if (this->filePath.isEmpty()) {
+        QString dataDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+        QDir().mkpath(dataDir);
+        this->filePath = dataDir + "/color.idx";
+    }
+    load();
+}
+
+void ColorIndex::load()
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    Header header;
+    if (file.read(reinterpret_cast<char *>(&header), sizeof(Header)) != qint64(sizeof(Header))
+        || header.magic != indexMagic || header.version != indexVersion || header.signatureSize != sizeof(Signature)
+        || file.size() != qint64(sizeof(Header)) + qint64(header.count) * (sizeof(quint32) + sizeof(Signature))) {
+        return;
+    }
+
+    days.resize(header.count);
+    signatures.resize(header.count);
+    const qint64 dayBytes = qint64(header.count) * sizeof(quint32);
+    const qint64 signatureBytes = qint64(header.count) * sizeof(Signature);
+    if (file.read(reinterpret_cast<char *>(days.data()), dayBytes) != dayBytes
+        || file.read(reinterpret_cast<char *>(signatures.data()), signatureBytes) != signatureBytes) {
+        days.clear();
+        signatures.clear();
+        return;
+    }
+    for (qsizetype i = 0; i < days.size(); ++i) {
+        positions.insert(days.at(i), i);
+    }
+}
+
+bool ColorIndex::commit()
+{
+    if (!dirty) {
+        return true;
+    }
+
+    Header header = {indexMagic, indexVersion, quint32(days.size()), quint32(sizeof(Signature))};
+    const qint64 dayBytes = days.size() * qint64(sizeof(quint32));
+    const qint64 signatureBytes = signatures.size() * qint64(sizeof(Signature));
+    QSaveFile file(filePath);
+    bool written = file.open(QIODevice::WriteOnly)
+        && file.write(reinterpret_cast<const char *>(&header), sizeof(Header)) == qint64(sizeof(Header))
+        && file.write(reinterpret_cast<const char *>(days.constData()), dayBytes) == dayBytes
+        && file.write(reinterpret_cast<const char *>(signatures.constData()), signatureBytes) == signatureBytes
+        && file.commit();
+    if (written) {
+        dirty = false;
+    }
+    return written;
+}
+
+ColorIndex::Signature ColorIndex::imageSignature(const QImage &image)
+{
+    Signature signature;
+    std::memset(&signature, 0, sizeof(Signature));
+    QImage source = image.convertToFormat(QImage::Format_RGB32);
+    const qint64 total = qint64(source.width()) * source.height();
+    if (total == 0) {
+        return signature;
+    }
+
+    int counts[BinCount] = {};
+    qint64 sums[BinCount][3] = {};
+    for (int y = 0; y < source.height(); ++y) {
+        const QRgb *line = reinterpret_cast<const QRgb *>(source.constScanLine(y));
+        for (int x = 0; x < source.width(); ++x) {
+            const int bin = binOf(line[x]);
+            counts[bin]++;
+            sums[bin][0] += qRed(line[x]);
+            sums[bin][1] += qGreen(line[x]);
+            sums[bin][2] += qBlue(line[x]);
+        }
+    }
+
+    int order[BinCount];
+    for (int bin = 0; bin < BinCount; ++bin) {
+        signature.histogram[bin] = quint8(qRound(counts[bin] * 255.0 / total));
+        order[bin] = bin;
+    }
+
+    // 像素最多的几个区间的平均颜色作为主色
+    std::partial_sort(order, order + DominantCount, order + BinCount, [&counts](int a, int b) {
+        return counts[a] > counts[b];
+    });
+    for (int i = 0; i < DominantCount && counts[order[i]] > 0; ++i) {
+        const int bin = order[i];
+        signature.dominant[i] = qRgb(int(sums[bin][0] / counts[bin]), int(sums[bin][1] / counts[bin]),
+                                     int(sums[bin][2] / counts[bin]));
+        signature.dominantShare[i] = quint8(qRound(counts[bin] * 255.0 / total));
+    }
+    return signature;
+}
+
+bool ColorIndex::signature(const QDate &date, Signature *value) const
+{
+    auto it = positions.constFind(date.toJulianDay());
+    if (it == positions.constEnd()) {
+        return false;
+    }
+    *value = signatures.at(it.value());
+    return true;
+}
+
+void ColorIndex::insert(const QDate &date, const Signature &signature)
+{
+    const qint64 day = date.toJulianDay();
+    auto it = positions.constFind(day);
+    if (it != positions.constEnd()) {
+        signatures[it.value()] = signature;
+    } else {
+        positions.insert(day, days.size());
+        days.append(quint32(day));
+        signatures.append(signature);
+    }
+    dirty = true;
+}
+
+QList<ColorIndex::Match> ColorIndex::nearest(const QColor &color, int limit, const QDate &exclude) const
+{
+    // 每个区间中心与目标颜色的相似度，查询时只需对直方图做一次点积
+    const QRgb target = color.rgb();
+    qint16 weights[BinCount];
+    for (int bin = 0; bin < BinCount; ++bin) {
+        weights[bin] = similarity(target, qRgb((bin >> 4) * 64 + 32, ((bin >> 2) & 3) * 64 + 32, (bin & 3) * 64 + 32));
+    }
+
+    // 直方图决定大部分得分，主色接近目标时再加分，区分同一区间内的颜色差异
+    const quint32 excludeDay = exclude.isValid() ? quint32(exclude.toJulianDay()) : 0;
+    QList<Match> matches;
+    matches.reserve(signatures.size());
+    for (qsizetype i = 0; i < signatures.size(); ++i) {
+        if (days.at(i) == excludeDay) {
+            continue;
+        }
+        const Signature &s = signatures.at(i);
+        double score = 0.7 * histogramScore(s.histogram, weights) / (255.0 * 256.0);
+        for (int k = 0; k < DominantCount; ++k) {
+            score += 0.3 * s.dominantShare[k] * similarity(target, s.dominant[k]) / (255.0 * 256.0);
+        }
+        matches.append(Match{QDate::fromJulianDay(days.at(i)), score});
+    }
+
+    limit = int(qMin<qsizetype>(qMax(0, limit), matches.size()));
+    std::partial_sort(matches.begin(), matches.begin() + limit, matches.end(), [](const Match &a, const Match &b) {
+        return a.score > b.score;
+    });
+    matches.resize(limit);
+    return matches;
+}
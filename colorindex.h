@@ -0,0 +1,64 @@
+#ifndef COLORINDEX_H
+#define COLORINDEX_H
+
+#include <QString>
+#include <QDate>
+#include <QImage>
+#include <QColor>
+#include <QList>
+#include <QHash>
+
+// 存档中每张图片的颜色特征，用于按颜色浏览
+// 特征为RGB各4级量化的64区间直方图和最多3个主色；
+// 文件结构: Header | quint32 julianDay[count] | Signature[count]，启动时整体读入内存
+class ColorIndex
+{
+public:
+    static const int BinCount = 64;
+    static const int DominantCount = 3;
+
+    struct Signature {
+        quint8 histogram[BinCount];            // 各区间的像素比例，总和约为255
+        quint32 dominant[DominantCount];       // 主色(QRgb)，按占比从大到小
+        quint8 dominantShare[DominantCount];   // 主色占比，0-255
+        quint8 reserved;
+    };
+
+    struct Match {
+        QDate date;
+        double score;  // 图片中接近目标颜色的比例，0-1
+    };
+
+    explicit ColorIndex(const QString &filePath = QString());
+
+    static Signature imageSignature(const QImage &image);
+
+    int count() const { return int(days.size()); }
+    bool contains(const QDate &date) const { return positions.contains(date.toJulianDay()); }
+    bool signature(const QDate &date, Signature *value) const;
+    void insert(const QDate &date, const Signature &signature);
+
+    // 接近color的像素比例最高的limit张，不包括exclude
+    QList<Match> nearest(const QColor &color, int limit, const QDate &exclude = QDate()) const;
+
+    bool hasPending() const { return dirty; }
+    bool commit();
+
+private:
+    struct Header {
+        quint32 magic;
+        quint32 version;
+        quint32 count;
+        quint32 signatureSize;
+    };
+
+    void load();
+
+    QString filePath;
+    QList<quint32> days;  // 儒略日，与signatures一一对应
+    QList<Signature> signatures;
+    QHash<qint64, qsizetype> positions;
+    bool dirty = false;
+};
+
+#endif // COLORINDEX_H
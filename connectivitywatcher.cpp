@@ -0,0 +1,121 @@
+#include "connectivitywatcher.h"
+
+namespace {
+const int minBackoff = 2000;
+const int maxBackoff = 5 * 60 * 1000;
+const int probeTimeout = 5000;
+}
+
+ConnectivityWatcher::ConnectivityWatcher(QNetworkAccessManager *manager, const QUrl &probeUrl, QObject *parent)
+    : QObject(parent)
+    , manager(manager)
+    , probeUrl(probeUrl)
+    , backoff(minBackoff)
+{
+    retryTimer.setSingleShot(true);
+    connect(&retryTimer, &QTimer::timeout, this, &ConnectivityWatcher::probe);
+}
+
+void ConnectivityWatcher::start()
+{
+    if (QNetworkInformation::loadBackendByFeatures(QNetworkInformation::Feature::Reachability)) {
+        info = QNetworkInformation::instance();
+        connect(info, &QNetworkInformation::reachabilityChanged, this, &ConnectivityWatcher::onReachabilityChanged);
+    }
+    // 在事件循环中检查，调用者构造完成后才会收到online
+    QTimer::singleShot(0, this, &ConnectivityWatcher::check);
+}
+
+bool ConnectivityWatcher::systemReportsOffline() const
+{
+    if (!info) {
+        return false;
+    }
+    QNetworkInformation::Reachability reachability = info->reachability();
+    return reachability == QNetworkInformation::Reachability::Disconnected
+        || reachability == QNetworkInformation::Reachability::Local;
+}
+
+void ConnectivityWatcher::check()
+{
+    if (ready) {
+        return;
+    }
+    if (info && info->reachability() == QNetworkInformation::Reachability::Online) {
+        setReady();
+    } else if (systemReportsOffline()) {
+        emit waiting();
+        scheduleProbe();
+    } else {
+        probe();
+    }
+}
+
+void ConnectivityWatcher::probe()
+{
+    if (ready || probeReply) {
+        return;
+    }
+
+    QNetworkRequest request(probeUrl);
+    request.setTransferTimeout(probeTimeout);
+    QNetworkReply *reply = manager->head(request);
+    probeReply = reply;
+    connect(reply, &QNetworkReply::finished, this, [this, reply]() {
+        reply->deleteLater();
+        if (probeReply == reply) {
+            probeReply = nullptr;
+        }
+        // 收到任何HTTP响应(包括403/404)都说明服务器可达
+        if (reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).isValid()) {
+            setReady();
+        } else {
+            emit waiting();
+            scheduleProbe();
+        }
+    });
+}
+
+void ConnectivityWatcher::scheduleProbe()
+{
+    // 系统报告离线时只做最长间隔的兜底探测，主要等待状态变化通知
+    if (systemReportsOffline()) {
+        retryTimer.start(maxBackoff);
+        return;
+    }
+    retryTimer.start(backoff);
+    backoff = qMin(backoff * 2, maxBackoff);
+}
+
+void ConnectivityWatcher::setReady()
+{
+    ready = true;
+    retryTimer.stop();
+    if (probeReply) {
+        QNetworkReply *reply = probeReply;
+        probeReply = nullptr;
+        reply->disconnect(this);
+        reply->abort();
+        reply->deleteLater();
+    }
+    if (info) {
+        info->disconnect(this);
+    }
+    emit online();
+}
+
+void ConnectivityWatcher::onReachabilityChanged(QNetworkInformation::Reachability reachability)
+{
+    if (ready) {
+        return;
+    }
+    if (reachability == QNetworkInformation::Reachability::Online) {
+        setReady();
+    } else if (reachability == QNetworkInformation::Reachability::Site
+               || reachability == QNetworkInformation::Reachability::Unknown) {
+        // 可能需要登录认证等，立即探测一次并重新开始退避
+        backoff = minBackoff;
+        retryTimer.stop();
+        probe();
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef CONNECTIVITYWATCHER_H
+#define CONNECTIVITYWATCHER_H
+
+#include <QObject>
+#include <QUrl>
+#include <QTimer>
+#include <QPointer>
+#include <QtNetwork/QNetworkAccessManager>
+#include <QtNetwork/QNetworkReply>
+#include <QtNetwork/QNetworkInformation>
+
+// 等待网络可用后发出一次online
+// 优先使用系统的网络状态通知(QNetworkInformation)：系统报告在线时立即发出，离线时只等待通知；
+// 系统不支持或状态未知时，按指数退避探测实际使用的元数据服务器
+class ConnectivityWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    ConnectivityWatcher(QNetworkAccessManager *manager, const QUrl &probeUrl, QObject *parent = nullptr);
+
+    void start();
+    bool isOnline() const { return ready; }
+
+signals:
+    void online();
+    void waiting();
+
+private:
+    void check();
+    void probe();
+    void scheduleProbe();
+    void setReady();
+    void onReachabilityChanged(QNetworkInformation::Reachability reachability);
+    bool systemReportsOffline() const;
+
+    QNetworkAccessManager *manager;
+    QUrl probeUrl;
+    QNetworkInformation *info = nullptr;
+    QPointer<QNetworkReply> probeReply;
+    QTimer retryTimer;
+    int backoff;
+    bool ready = false;
+};
+
+#endif // CONNECTIVITYWATCHER_H
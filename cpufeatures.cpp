@@ -0,0 +1,37 @@
+#include "cpufeatures.h"
+
+#if defined(Q_PROCESSOR_X86) && defined(Q_CC_MSVC)
+#  include <intrin.h>
+#endif
+
+namespace {
+
+bool detectAvx2()
+{
+#if defined(Q_PROCESSOR_X86) && defined(Q_CC_MSVC)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    // 还需要系统保存YMM寄存器
+    __cpuid(info, 1);
+    if (!(info[2] & (1 << 27)) || !(info[2] & (1 << 28)) || (_xgetbv(0) & 6) != 6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return info[1] & (1 << 5);
+#elif defined(Q_PROCESSOR_X86)
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+}
+
+bool cpuHasAvx2()
+{
+    static const bool avx2 = detectAvx2();
+    return avx2;
+}
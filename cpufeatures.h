@@ -0,0 +1,19 @@
+#ifndef CPUFEATURES_H
+#define CPUFEATURES_H
+
+#include <QtGlobal>
+
+// 运行时选择SIMD实现
+// x86上SSE2是Qt 6的基本要求可直接使用；AVX2函数用CPU_TARGET_AVX2单独编译，调用前先检查cpuHasAvx2()
+#if defined(Q_PROCESSOR_X86)
+#  include <immintrin.h>
+#  if defined(Q_CC_MSVC)
+#    define CPU_TARGET_AVX2
+#  else
+#    define CPU_TARGET_AVX2 __attribute__((target("avx2")))
+#  endif
+#endif
+
+bool cpuHasAvx2();
+
+#endif // CPUFEATURES_H
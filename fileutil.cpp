@@ -0,0 +1,133 @@
+#include "fileutil.h"
+
+#include <QDir>
+#include <QFile>
+#include <QCryptographicHash>
+#ifdef Q_OS_WIN
+#include <Windows.h>
+#include <winioctl.h>
+#else
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#ifdef Q_OS_LINUX
+#include <linux/fs.h>
+#endif
+#endif
+
+bool replaceFile(const QString &from, const QString &to)
+{
+#ifdef Q_OS_WIN
+    QString nativeFrom = QDir::toNativeSeparators(from);
+    QString nativeTo = QDir::toNativeSeparators(to);
+    return MoveFileExW(reinterpret_cast<const wchar_t *>(nativeFrom.utf16()),
+                       reinterpret_cast<const wchar_t *>(nativeTo.utf16()),
+                       MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    return std::rename(QFile::encodeName(from).constData(), QFile::encodeName(to).constData()) == 0;
+#endif
+}
+
+bool cloneFile(const QString &existing, const QString &newPath)
+{
+#ifdef Q_OS_WIN
+    QString nativeExisting = QDir::toNativeSeparators(existing);
+    QString nativeNew = QDir::toNativeSeparators(newPath);
+    HANDLE source = CreateFileW(reinterpret_cast<const wchar_t *>(nativeExisting.utf16()), GENERIC_READ,
+                                FILE_SHARE_READ, nullptr, OPEN_EXISTING, 0, nullptr);
+    if (source == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    HANDLE target = CreateFileW(reinterpret_cast<const wchar_t *>(nativeNew.utf16()), GENERIC_READ | GENERIC_WRITE | DELETE,
+                                0, nullptr, CREATE_NEW, 0, nullptr);
+    if (target == INVALID_HANDLE_VALUE) {
+        CloseHandle(source);
+        return false;
+    }
+
+    // 块克隆以簇为单位：目标先设为相同大小，克隆的长度向上取整到簇大小；
+    // 源文件启用了完整性流时目标也必须启用
+    bool cloned = false;
+    LARGE_INTEGER size;
+    FSCTL_GET_INTEGRITY_INFORMATION_BUFFER integrity = {};
+    DWORD bytes = 0;
+    if (GetFileSizeEx(source, &size)
+        && DeviceIoControl(source, FSCTL_GET_INTEGRITY_INFORMATION, nullptr, 0,
+                           &integrity, sizeof(integrity), &bytes, nullptr)
+        && integrity.ClusterSizeInBytes > 0) {
+        FSCTL_SET_INTEGRITY_INFORMATION_BUFFER setIntegrity = {};
+        setIntegrity.ChecksumAlgorithm = integrity.ChecksumAlgorithm;
+        setIntegrity.Flags = integrity.Flags;
+        FILE_END_OF_FILE_INFO endOfFile;
+        endOfFile.EndOfFile = size;
+        DUPLICATE_EXTENTS_DATA extents = {};
+        extents.FileHandle = source;
+        extents.ByteCount.QuadPart = (size.QuadPart + integrity.ClusterSizeInBytes - 1)
+            / integrity.ClusterSizeInBytes * integrity.ClusterSizeInBytes;
+        cloned = (integrity.ChecksumAlgorithm == 0
+                  || DeviceIoControl(target, FSCTL_SET_INTEGRITY_INFORMATION, &setIntegrity, sizeof(setIntegrity),
+                                     nullptr, 0, &bytes, nullptr))
+            && SetFileInformationByHandle(target, FileEndOfFileInfo, &endOfFile, sizeof(endOfFile))
+            && (size.QuadPart == 0
+                || DeviceIoControl(target, FSCTL_DUPLICATE_EXTENTS_TO_FILE, &extents, sizeof(extents),
+                                   nullptr, 0, &bytes, nullptr));
+    }
+    if (!cloned) {
+        // 不支持块克隆(例如NTFS)时删除刚建立的空文件
+        FILE_DISPOSITION_INFO disposition = {TRUE};
+        SetFileInformationByHandle(target, FileDispositionInfo, &disposition, sizeof(disposition));
+    }
+    CloseHandle(target);
+    CloseHandle(source);
+    return cloned;
+#elif defined(FICLONE)
+    int source = ::open(QFile::encodeName(existing).constData(), O_RDONLY);
+    if (source < 0) {
+        return false;
+    }
+    int target = ::open(QFile::encodeName(newPath).constData(), O_WRONLY | O_CREAT | O_EXCL, 0644);
+    if (target < 0) {
+        ::close(source);
+        return false;
+    }
+    bool cloned = ::ioctl(target, FICLONE, source) == 0;
+    ::close(target);
+    ::close(source);
+    if (!cloned) {
+        ::unlink(QFile::encodeName(newPath).constData());
+    }
+    return cloned;
+#else
+    Q_UNUSED(existing);
+    Q_UNUSED(newPath);
+    return false;
+#endif
+}
+
+bool linkFile(const QString &existing, const QString &newPath)
+{
+#ifdef Q_OS_WIN
+    QString nativeExisting = QDir::toNativeSeparators(existing);
+    QString nativeNew = QDir::toNativeSeparators(newPath);
+    return CreateHardLinkW(reinterpret_cast<const wchar_t *>(nativeNew.utf16()),
+                           reinterpret_cast<const wchar_t *>(nativeExisting.utf16()),
+                           nullptr) != 0;
+#else
+    return ::link(QFile::encodeName(existing).constData(), QFile::encodeName(newPath).constData()) == 0;
+#endif
+}
+
+QByteArray fileSha256(const QString &filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    if (!hash.addData(&file)) {
+        return QByteArray();
+    }
+    return hash.result().toHex();
+}
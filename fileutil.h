@@ -0,0 +1,20 @@
+#ifndef FILEUTIL_H
+#define FILEUTIL_H
+
+#include <QString>
+#include <QByteArray>
+
+// 用from原子替换to，to已存在时覆盖
+bool replaceFile(const QString &from, const QString &to);
+
+// 在ReFS/Dev Drive(Linux为btrfs、XFS等)上建立共享数据块的副本(reflink)，
+// 写入副本时才复制被修改的块，不影响原文件；两者需在同一分区，文件系统不支持时返回false
+bool cloneFile(const QString &existing, const QString &newPath);
+
+// 为已有文件建立硬链接，不复制数据；两者需在同一分区
+bool linkFile(const QString &existing, const QString &newPath);
+
+// 分块计算文件的SHA-256，返回十六进制字符串；读取失败时返回空
+QByteArray fileSha256(const QString &filePath);
+
+#endif // FILEUTIL_H
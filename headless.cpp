@@ -0,0 +1,64 @@
+#include "headless.h"
+#include "platform.h"
+
+#include <QCoreApplication>
+#include <QSettings>
+#include <cstdio>
+
+HeadlessRunner::HeadlessRunner(QObject *parent)
+    : QObject(parent)
+    , configPath(QCoreApplication::applicationDirPath() + "/mybing.conf")
+{
+    connect(&fetcher, &WallpaperFetcher::metadataReady, this, &HeadlessRunner::onMetadataReady);
+    connect(&fetcher, &WallpaperFetcher::imageReady, this, &HeadlessRunner::onImageReady);
+    connect(&fetcher, &WallpaperFetcher::failed, this, &HeadlessRunner::onFailed);
+
+    QSettings settings(configPath, QSettings::IniFormat);
+    fetcher.setImageSegments(settings.value("downloadSegments", 4).toInt());
+    fetcher.setMetadataMirrors(settings.value("metadataMirrors").toStringList());
+}
+
+void HeadlessRunner::apply(const QDate &date)
+{
+    targetDate = date;
+    fetcher.warmConnections();
+    fetcher.fetchMetadata(date.toString("yyyyMMdd"));
+}
+
+void HeadlessRunner::onMetadataReady(const QString &date, const QString &imgtitle, const QString &imgurl)
+{
+    Q_UNUSED(date);
+    std::printf("%s %s\n", qPrintable(targetDate.toString("yyyy-MM-dd")), imgtitle.toLocal8Bit().constData());
+    fetcher.fetchImage(imgurl);
+}
+
+void HeadlessRunner::onImageReady(const QString &imgurl, const QString &filePath)
+{
+    Q_UNUSED(imgurl);
+    // 按各显示器的分辨率生成壁纸，无法逐个显示器设置时使用原图
+    QList<DesktopMonitor> monitors = desktopMonitors();
+    if (!setMonitorWallpapers(monitors, renderer.renderAll(filePath, monitors)) && !setDesktopWallpaper(filePath)) {
+        std::fprintf(stderr, "failed to set wallpaper: %s\n", qPrintable(filePath));
+        emit finished(false);
+        return;
+    }
+
+    QSettings settings(configPath, QSettings::IniFormat);
+    if (settings.value("setLockScreenWallpaper_enabled", false).toBool()) {
+        setLockScreenWallpaper(filePath);
+    }
+    // 界面模式启动时据此判断是否已是今日壁纸
+    settings.setValue("lastSelectedDate", targetDate.toString("yyyyMMdd"));
+
+    std::printf("wallpaper applied in %lld ms after process start\n", msecsSinceProcessStart());
+    std::printf("%s\n", qPrintable(fetcher.network()->statsSummary()));
+    std::printf("%s\n", qPrintable(fetcher.mirrorSummary()));
+    emit finished(true);
+}
+
+void HeadlessRunner::onFailed(WallpaperFetcher::Stage stage, const QString &message)
+{
+    Q_UNUSED(stage);
+    std::fprintf(stderr, "%s\n", message.toLocal8Bit().constData());
+    emit finished(false);
+}
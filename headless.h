@@ -0,0 +1,36 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include <QObject>
+#include <QDate>
+#include <QString>
+#include "wallpaperfetcher.h"
+#include "wallpaperrenderer.h"
+
+// 无界面设置一天的壁纸后退出，供计划任务调用
+// 只创建QCoreApplication和WallpaperFetcher，不加载界面、托盘和图标；
+// 锁屏壁纸设置和上次选择的日期与界面模式共用mybing.conf
+class HeadlessRunner : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit HeadlessRunner(QObject *parent = nullptr);
+
+    void apply(const QDate &date);
+
+signals:
+    void finished(bool ok);
+
+private:
+    void onMetadataReady(const QString &date, const QString &imgtitle, const QString &imgurl);
+    void onImageReady(const QString &imgurl, const QString &filePath);
+    void onFailed(WallpaperFetcher::Stage stage, const QString &message);
+
+    WallpaperFetcher fetcher;
+    WallpaperRenderer renderer;
+    QString configPath;
+    QDate targetDate;
+};
+
+#endif // HEADLESS_H
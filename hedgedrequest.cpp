@@ -0,0 +1,141 @@
+#include "hedgedrequest.h"
+
+HedgedRequest::HedgedRequest(QNetworkAccessManager *manager, MirrorSet *mirrors, const QNetworkRequest &request,
+                             const QString &path, QObject *parent)
+    : QObject(parent)
+    , manager(manager)
+    , mirrors(mirrors)
+    , request(request)
+    , path(path)
+{
+    hedgeTimer.setSingleShot(true);
+    connect(&hedgeTimer, &QTimer::timeout, this, [this]() {
+        // 只发一个对冲请求，避免放大对服务器的压力
+        if (!done && attempts.size() == 1) {
+            launchNext();
+        }
+    });
+    deadlineTimer.setSingleShot(true);
+    connect(&deadlineTimer, &QTimer::timeout, this, &HedgedRequest::onDeadline);
+}
+
+HedgedRequest::~HedgedRequest()
+{
+    abort();
+}
+
+void HedgedRequest::setDeadline(int msecs)
+{
+    deadlineTimer.setInterval(msecs);
+}
+
+void HedgedRequest::start()
+{
+    order = mirrors->ranked();
+    nextMirror = 0;
+    if (!launchNext()) {
+        return;
+    }
+    if (order.size() > 1) {
+        hedgeTimer.start(mirrors->hedgeDelay(order.first()));
+    }
+    if (deadlineTimer.interval() > 0) {
+        deadlineTimer.start();
+    }
+}
+
+void HedgedRequest::abort()
+{
+    done = true;
+    hedgeTimer.stop();
+    deadlineTimer.stop();
+    abortAttempts();
+}
+
+bool HedgedRequest::launchNext()
+{
+    if (nextMirror >= order.size()) {
+        return false;
+    }
+
+    Attempt attempt;
+    attempt.mirror = order.at(nextMirror++);
+    QNetworkRequest mirrorRequest(request);
+    mirrorRequest.setUrl(mirrors->url(attempt.mirror, path));
+    attempt.reply = manager->get(mirrorRequest);
+    attempt.timer.start();
+    attempts.append(attempt);
+
+    QNetworkReply *reply = attempt.reply;
+    connect(reply, &QNetworkReply::finished, this, [this, reply]() {
+        onAttemptFinished(reply);
+    });
+    return true;
+}
+
+void HedgedRequest::onAttemptFinished(QNetworkReply *reply)
+{
+    int index = -1;
+    for (int i = 0; i < attempts.size(); ++i) {
+        if (attempts.at(i).reply == reply) {
+            index = i;
+            break;
+        }
+    }
+    if (index < 0 || done) {
+        return;
+    }
+    Attempt attempt = attempts.takeAt(index);
+
+    if (reply->error() == QNetworkReply::NoError && (!validator || validator(reply))) {
+        mirrors->recordSuccess(attempt.mirror, attempt.timer.elapsed());
+        finish(reply);
+        return;
+    }
+
+    mirrors->recordFailure(attempt.mirror);
+    // 另一个镜像的请求还在进行，等待它的结果；否则立即换下一个镜像
+    if (!attempts.isEmpty() || launchNext()) {
+        reply->deleteLater();
+        return;
+    }
+    finish(reply);
+}
+
+void HedgedRequest::onDeadline()
+{
+    if (done || attempts.isEmpty()) {
+        return;
+    }
+
+    // 超时的镜像都记为失败，以最后发出的请求作为结果
+    Attempt last = attempts.takeLast();
+    for (const Attempt &attempt : std::as_const(attempts)) {
+        mirrors->recordFailure(attempt.mirror);
+    }
+    mirrors->recordFailure(last.mirror);
+    last.reply->disconnect(this);
+    last.reply->setProperty("timedOut", true);
+    last.reply->abort();
+    finish(last.reply);
+}
+
+void HedgedRequest::finish(QNetworkReply *reply)
+{
+    done = true;
+    hedgeTimer.stop();
+    deadlineTimer.stop();
+    abortAttempts();
+    emit finished(reply);
+}
+
+void HedgedRequest::abortAttempts()
+{
+    const QList<Attempt> pending = attempts;
+    attempts.clear();
+    for (const Attempt &attempt : pending) {
+        attempt.reply->disconnect(this);
+        attempt.reply->abort();
+        attempt.reply->deleteLater();
+    }
+}
@@ -0,0 +1,62 @@
+#ifndef HEDGEDREQUEST_H
+#define HEDGEDREQUEST_H
+
+#include <QObject>
+#include <QList>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <functional>
+#include <QtNetwork/QNetworkAccessManager>
+#include <QtNetwork/QNetworkRequest>
+#include <QtNetwork/QNetworkReply>
+#include "mirrorset.h"
+
+// 向最快的健康镜像发出请求，超过该镜像延迟的90百分位仍未完成时向下一个镜像发出对冲请求，
+// 先成功的响应生效，其余取消；失败时立即换下一个镜像。结果计入MirrorSet的统计
+class HedgedRequest : public QObject
+{
+    Q_OBJECT
+
+public:
+    HedgedRequest(QNetworkAccessManager *manager, MirrorSet *mirrors, const QNetworkRequest &request,
+                  const QString &path, QObject *parent = nullptr);
+    ~HedgedRequest();
+
+    // 整个请求(包括对冲和换源)的截止时间，超时的响应带有timedOut属性
+    void setDeadline(int msecs);
+    // 状态正常但内容不对(如HTTP 200的错误页、认证页面)的响应按失败处理，换下一个镜像
+    void setValidator(std::function<bool(QNetworkReply *)> validator) { this->validator = std::move(validator); }
+    void start();
+    void abort();
+
+signals:
+    // 第一个成功的响应；全部失败时为最后一个失败的响应。reply由接收者删除
+    void finished(QNetworkReply *reply);
+
+private:
+    struct Attempt {
+        QNetworkReply *reply;
+        int mirror;
+        QElapsedTimer timer;
+    };
+
+    bool launchNext();
+    void onAttemptFinished(QNetworkReply *reply);
+    void onDeadline();
+    void finish(QNetworkReply *reply);
+    void abortAttempts();
+
+    QNetworkAccessManager *manager;
+    MirrorSet *mirrors;
+    QNetworkRequest request;
+    QString path;
+    std::function<bool(QNetworkReply *)> validator;
+    QList<int> order;
+    int nextMirror = 0;
+    QList<Attempt> attempts;
+    QTimer hedgeTimer;
+    QTimer deadlineTimer;
+    bool done = false;
+};
+
+#endif // HEDGEDREQUEST_H
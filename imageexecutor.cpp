@@ -0,0 +1,22 @@
+#include "imageexecutor.h"
+
+#include <QThread>
+
+ImageExecutor::ImageExecutor(QObject *parent)
+    : QObject(parent)
+{
+    // 给界面线程留出一个核心，最多4个线程
+    setMaxThreads(qBound(1, QThread::idealThreadCount() - 1, 4));
+    pool.setObjectName("ImageExecutor");
+}
+
+ImageExecutor::~ImageExecutor()
+{
+    pool.clear();
+    pool.waitForDone();
+}
+
+void ImageExecutor::setMaxThreads(int count)
+{
+    pool.setMaxThreadCount(qMax(1, count));
+}
@@ -0,0 +1,50 @@
+#ifndef IMAGEEXECUTOR_H
+#define IMAGEEXECUTOR_H
+
+#include <QObject>
+#include <QPointer>
+#include <QThreadPool>
+#include <functional>
+#include <utility>
+
+// 图片解码、缩放、编码和文件写入的线程池
+// 线程数有上限，批量处理大量图片时不会占满CPU；优先级高的任务先执行，
+// 前台预览总是排在后台预取和批量任务之前。结果以移动方式送回context所在的界面线程
+class ImageExecutor : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Priority {
+        BackgroundPriority = 0, // 批量任务、图标等
+        PrefetchPriority = 1,   // 预取
+        ForegroundPriority = 2  // 当前显示的预览、用户操作
+    };
+
+    explicit ImageExecutor(QObject *parent = nullptr);
+    ~ImageExecutor();
+
+    void setMaxThreads(int count);
+    int maxThreads() const { return pool.maxThreadCount(); }
+
+    // 在线程池中执行task，完成后在界面线程以结果调用done；context已删除时丢弃结果
+    template <typename Result>
+    void run(Priority priority, QObject *context, std::function<Result()> task, std::function<void(Result)> done)
+    {
+        QPointer<QObject> guard(context);
+        pool.start([this, guard, task = std::move(task), done = std::move(done)]() mutable {
+            Result result = task();
+            // 执行器删除时会等待所有任务结束，尚未送达的结果随之丢弃
+            QMetaObject::invokeMethod(this, [guard, done = std::move(done), result = std::move(result)]() mutable {
+                if (guard) {
+                    done(std::move(result));
+                }
+            }, Qt::QueuedConnection);
+        }, priority);
+    }
+
+private:
+    QThreadPool pool;
+};
+
+#endif // IMAGEEXECUTOR_H
@@ -0,0 +1,70 @@
+#include "imageindexer.h"
+#include "wallpaperfetcher.h"
+#include "imageexecutor.h"
+#include "previewdecoder.h"
+#include "perceptualindex.h"
+#include "colorindex.h"
+
+ImageIndexer::ImageIndexer(WallpaperFetcher *fetcher, ImageExecutor *executor, QObject *parent)
+    : QObject(parent)
+    , fetcher(fetcher)
+    , executor(executor)
+{
+}
+
+void ImageIndexer::indexArchive()
+{
+    for (QDate date = ArchiveIndex::firstDate(); date <= QDate::currentDate(); date = date.addDays(1)) {
+        QString imgtitle, imgurl;
+        if (isIndexed(date) || !fetcher->cachedMetadata(date.toString("yyyyMMdd"), &imgtitle, &imgurl)) {
+            continue;
+        }
+        QString storedPath = fetcher->imageStore()->find(imgurl);
+        if (!storedPath.isEmpty()) {
+            add(date, storedPath);
+        }
+    }
+}
+
+bool ImageIndexer::isIndexed(const QDate &date) const
+{
+    return fetcher->perceptualIndex()->contains(date) && fetcher->colorIndex()->contains(date);
+}
+
+void ImageIndexer::add(const QDate &date, const QString &filePath)
+{
+    pending++;
+    executor->run<Features>(ImageExecutor::BackgroundPriority, this, [filePath]() {
+        return extract(filePath);
+    }, [this, date](Features features) {
+        PerceptualIndex *perceptual = fetcher->perceptualIndex();
+        ColorIndex *colors = fetcher->colorIndex();
+        if (features.valid) {
+            perceptual->insert(date, features.hash);
+            colors->insert(date, features.color);
+            // 批量建立时定期写入，中途退出不会丢失全部结果
+            if (++indexed % 200 == 0) {
+                perceptual->commit();
+                colors->commit();
+            }
+        }
+        if (--pending == 0) {
+            perceptual->commit();
+            colors->commit();
+            emit finished(indexed);
+            indexed = 0;
+        }
+    });
+}
+
+ImageIndexer::Features ImageIndexer::extract(const QString &filePath)
+{
+    Features features;
+    QImage image = PreviewDecoder::decodeScaledFile(filePath, QSize(64, 64));
+    if (!image.isNull()) {
+        features.valid = true;
+        features.hash = PerceptualIndex::imageHash(image);
+        features.color = ColorIndex::imageSignature(image);
+    }
+    return features;
+}
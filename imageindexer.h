@@ -0,0 +1,46 @@
+#ifndef IMAGEINDEXER_H
+#define IMAGEINDEXER_H
+
+#include <QObject>
+#include <QDate>
+#include <QString>
+#include "colorindex.h"
+
+class WallpaperFetcher;
+class ImageExecutor;
+
+// 在图片线程池中为已存储的原图计算图片特征(感知哈希、颜色)，写入WallpaperFetcher的索引
+// 每张图片只在DCT阶段按1/8解码一次，各特征都从同一张缩略图计算；多张图片在线程池中并行，
+// 任务为后台优先级，不影响前台预览
+class ImageIndexer : public QObject
+{
+    Q_OBJECT
+
+public:
+    ImageIndexer(WallpaperFetcher *fetcher, ImageExecutor *executor, QObject *parent = nullptr);
+
+    // 扫描整个存档，为已下载但尚未建立索引的日期计算特征
+    void indexArchive();
+    void add(const QDate &date, const QString &filePath);
+    bool isIndexed(const QDate &date) const;
+    bool isIdle() const { return pending == 0; }
+
+signals:
+    void finished(int indexedCount);
+
+private:
+    struct Features {
+        bool valid = false;
+        quint64 hash = 0;
+        ColorIndex::Signature color = {};
+    };
+
+    static Features extract(const QString &filePath);
+
+    WallpaperFetcher *fetcher;
+    ImageExecutor *executor;
+    int pending = 0;
+    int indexed = 0;
+};
+
+#endif // IMAGEINDEXER_H
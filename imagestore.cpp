@@ -0,0 +1,153 @@
+#include "imagestore.h"
+#include "fileutil.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QCryptographicHash>
+
+ImageStore::ImageStore(const QString &dirPath)
+{
+    storeDir = dirPath.isEmpty() ?
+        QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/store" :
+        dirPath;
+    QDir().mkpath(storeDir);
+    indexPath = storeDir + "/urls.ini";
+}
+
+QString ImageStore::incomingPath(const QString &imgurl) const
+{
+    QByteArray hash = QCryptographicHash::hash(imgurl.toUtf8(), QCryptographicHash::Sha1).toHex().left(16);
+    return storeDir + "/incoming-" + QString::fromLatin1(hash) + ".jpg";
+}
+
+QString ImageStore::objectPath(const QByteArray &hash) const
+{
+    return storeDir + "/" + QString::fromLatin1(hash) + ".jpg";
+}
+
+QString ImageStore::urlKey(const QString &imgurl, const QString &group)
+{
+    return group + "/" + QString::fromLatin1(QCryptographicHash::hash(imgurl.toUtf8(), QCryptographicHash::Sha1).toHex());
+}
+
+// 存储中的图片设为只读，硬链接到图片文件夹的文件同样只读，编辑软件不会原地改写
+static void setReadOnly(const QString &path, bool readOnly)
+{
+    const QFileDevice::Permissions writable = QFileDevice::WriteOwner | QFileDevice::WriteUser;
+    QFile::Permissions permissions = QFile::permissions(path);
+    QFile::setPermissions(path, readOnly ? permissions & ~writable : permissions | writable);
+}
+
+QString ImageStore::verifiedObject(const QString &key) const
+{
+    QSettings index(indexPath, QSettings::IniFormat);
+    QByteArray hash = index.value(key).toByteArray();
+    if (hash.isEmpty()) {
+        return QString();
+    }
+
+    QString path = objectPath(hash);
+    QFileInfo info(path);
+    if (!info.exists()) {
+        return QString();
+    }
+    // 只读属性被去掉(或旧版本存入)的图片可能已被修改，重新校验后才使用
+    if (info.isWritable()) {
+        if (fileSha256(path) != hash) {
+            QFile::remove(path);
+            index.remove(key);
+            return QString();
+        }
+        setReadOnly(path, true);
+    }
+    return path;
+}
+
+QString ImageStore::find(const QString &imgurl) const
+{
+    return verifiedObject(urlKey(imgurl));
+}
+
+QString ImageStore::add(const QString &imgurl, const QString &filePath)
+{
+    QByteArray hash = fileSha256(filePath);
+    if (hash.isEmpty()) {
+        return QString();
+    }
+
+    // 相同内容已存储(例如同一图片的不同url)时丢弃新文件
+    // 已存储的文件可写时可能已被修改，用新下载的文件替换
+    QString path = objectPath(hash);
+    QFileInfo info(path);
+    if (info.exists() && !info.isWritable()) {
+        QFile::remove(filePath);
+    } else if (!replaceFile(filePath, path)) {
+        return QString();
+    } else {
+        setReadOnly(path, true);
+    }
+
+    QSettings index(indexPath, QSettings::IniFormat);
+    index.setValue(urlKey(imgurl), hash);
+    index.remove(urlKey(imgurl, "aliases"));
+    return path;
+}
+
+bool ImageStore::alias(const QString &imgurl, const QString &storedPath)
+{
+    QFileInfo info(storedPath);
+    if (!info.exists() || info.absolutePath() != QFileInfo(storeDir).absoluteFilePath()) {
+        return false;
+    }
+
+    QSettings index(indexPath, QSettings::IniFormat);
+    index.setValue(urlKey(imgurl, "aliases"), info.completeBaseName().toLatin1());
+    return true;
+}
+
+QString ImageStore::findAlias(const QString &imgurl) const
+{
+    return verifiedObject(urlKey(imgurl, "aliases"));
+}
+
+void ImageStore::removeAlias(const QString &imgurl)
+{
+    QSettings index(indexPath, QSettings::IniFormat);
+    index.remove(urlKey(imgurl, "aliases"));
+}
+
+bool ImageStore::place(const QString &storedPath, const QString &destPath)
+{
+    // 目标已是相同内容时无需任何操作
+    QFileInfo destInfo(destPath);
+    if (destInfo.exists() && destInfo.size() == QFileInfo(storedPath).size()
+        && fileSha256(destPath) == QFileInfo(storedPath).completeBaseName().toLatin1()) {
+        return true;
+    }
+
+    // 先在旁边建立副本再原子替换，目标文件不会出现不完整的状态；
+    // 依次尝试reflink(写入时才复制，可随意编辑)、硬链接(与存储一起只读)，
+    // 跨分区或文件系统都不支持时才复制数据
+    QString tempPath = destPath + ".tmp";
+    setReadOnly(tempPath, false);
+    QFile::remove(tempPath);
+    if (!cloneFile(storedPath, tempPath) && !linkFile(storedPath, tempPath)) {
+        if (!QFile::copy(storedPath, tempPath)) {
+            return false;
+        }
+        // 复制会带上只读属性，复制出的文件与存储无关，恢复为可写
+        setReadOnly(tempPath, false);
+    }
+    // 只读的目标文件不能被替换(可能是以前建立的硬链接)
+    if (destInfo.exists() && !destInfo.isWritable()) {
+        setReadOnly(destPath, false);
+    }
+    if (!replaceFile(tempPath, destPath)) {
+        QFile::remove(tempPath);
+        return false;
+    }
+    return true;
+}
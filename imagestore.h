@@ -0,0 +1,45 @@
+#ifndef IMAGESTORE_H
+#define IMAGESTORE_H
+
+#include <QString>
+#include <QByteArray>
+
+// 按内容寻址的本地图片存储，每张图片以SHA-256命名只保存一份
+// 并记录url到内容的对应关系，已存储的图片不再访问网络；
+// 存储中的文件为只读，保存到图片文件夹时共享数据而不是复制
+class ImageStore
+{
+public:
+    explicit ImageStore(const QString &dirPath = QString());
+
+    // 下载目标路径，与存储目录在同一分区，下载完成后直接改名移入
+    QString incomingPath(const QString &imgurl) const;
+
+    // 已存储时返回图片路径，否则返回空
+    QString find(const QString &imgurl) const;
+    bool contains(const QString &imgurl) const { return !find(imgurl).isEmpty(); }
+
+    // 把下载好的文件移入存储，内容已存在时删除该文件；返回存储中的路径，失败返回空
+    QString add(const QString &imgurl, const QString &filePath);
+
+    // imgurl与已存储的图片为同一张(例如重新发布的壁纸)时直接对应到该图片，不再下载；
+    // 别名与真正下载的记录分开保存，find不会返回别名，下载该url后别名自动删除
+    bool alias(const QString &imgurl, const QString &storedPath);
+    QString findAlias(const QString &imgurl) const;
+    void removeAlias(const QString &imgurl);
+
+    // 把存储中的图片放到destPath：优先reflink，其次硬链接，跨分区时复制；destPath已存在时替换
+    // 硬链接的文件与存储一样只读，去掉只读后修改的图片在find时校验不通过，会被移出存储
+    static bool place(const QString &storedPath, const QString &destPath);
+
+private:
+    QString objectPath(const QByteArray &hash) const;
+    // 按索引中的key返回图片路径，图片可写时先校验SHA-256，内容不符时移出存储
+    QString verifiedObject(const QString &key) const;
+    static QString urlKey(const QString &imgurl, const QString &group = "urls");
+
+    QString storeDir;
+    QString indexPath;
+};
+
+#endif // IMAGESTORE_H
@@ -1,9 +1,124 @@
 #include "mainwindow.h"
+#include "archivesync.h"
+#include "headless.h"
+#include "platform.h"
 
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QRandomGenerator>
+#include <cstdio>
+#ifdef MYBING_BENCH
+#include "benchmark.h"
+#endif
+
+// mybingwallpaper --sync|--save-range [起始日期] [结束日期] [--jobs n] [--per-host n] [--retries n] [--out 目录]
+// --save-range与--sync相同，默认保存到用户图片文件夹
+static int runSync(QCoreApplication &a, const QString &defaultOutputDir)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("同步一段日期的原图到本地存储");
+    parser.addHelpOption();
+    parser.addOptions({
+        {"sync", "同步模式"},
+        {"save-range", "同步并保存到图片文件夹"},
+        {"jobs", "总并发连接数", "n", "8"},
+        {"per-host", "每个主机的并发连接数", "n", "4"},
+        {"retries", "失败后的重试次数", "n", "4"},
+        {"out", "同时以yyyy-MM-dd.jpg保存到该目录", "dir", defaultOutputDir},
+    });
+    parser.addPositionalArgument("from", "起始日期yyyyMMdd，默认20100101");
+    parser.addPositionalArgument("to", "结束日期yyyyMMdd，默认今天");
+    parser.process(a);
+
+    const QStringList dates = parser.positionalArguments();
+    QDate from = QDate::fromString(dates.value(0, "20100101"), "yyyyMMdd");
+    QDate to = dates.size() > 1 ? QDate::fromString(dates.at(1), "yyyyMMdd") : QDate::currentDate();
+    if (!from.isValid() || !to.isValid()) {
+        std::fprintf(stderr, "invalid date\n");
+        return 2;
+    }
+
+    WallpaperFetcher fetcher;
+    ArchiveSync sync(&fetcher);
+    sync.setRange(from, to);
+    sync.setMaxConnections(parser.value("jobs").toInt());
+    sync.setMaxPerHost(parser.value("per-host").toInt());
+    sync.setMaxRetries(parser.value("retries").toInt());
+    sync.setOutputDir(parser.value("out"));
+    QObject::connect(&sync, &ArchiveSync::finished, &a, [](int failedCount) {
+        QCoreApplication::exit(failedCount > 0 ? 1 : 0);
+    });
+    QMetaObject::invokeMethod(&sync, &ArchiveSync::start, Qt::QueuedConnection);
+    return a.exec();
+}
+
+// mybingwallpaper --apply-today | --apply-date yyyyMMdd | --random
+static int runApply(QCoreApplication &a, const QString &mode)
+{
+    QDate date = QDate::currentDate();
+    if (mode == "--apply-date") {
+        date = QDate::fromString(a.arguments().value(2), "yyyyMMdd");
+    } else if (mode == "--random") {
+        // 随机日期, 不早于2010-01-01
+        QDate startDate(2010, 1, 1);
+        date = startDate.addDays(QRandomGenerator::global()->bounded(startDate.daysTo(date)));
+    }
+    if (!date.isValid() || date < QDate(2010, 1, 1) || date > QDate::currentDate()) {
+        std::fprintf(stderr, "invalid date\n");
+        return 2;
+    }
+
+    HeadlessRunner runner;
+    QObject::connect(&runner, &HeadlessRunner::finished, &a, [](bool ok) {
+        QCoreApplication::exit(ok ? 0 : 1);
+    });
+    // 已存储的图片会同步完成，finished须在事件循环启动后发出，否则exit无效
+    QMetaObject::invokeMethod(&runner, [&runner, date]() {
+        runner.apply(date);
+    }, Qt::QueuedConnection);
+    return a.exec();
+}
 
 int main(int argc, char *argv[])
 {
+    const QString mode = argc > 1 ? QString::fromLocal8Bit(argv[1]) : QString();
+
+#ifdef MYBING_BENCH
+    if (mode == "--bench") {
+        QCoreApplication a(argc, argv);
+        return runBenchmarks(a.arguments().mid(2));
+    }
+#endif
+
+    // 以下命令行模式不创建界面，执行完成后退出
+    if (mode == "--build-index") {
+        // 建立/补全存档索引
+        attachParentConsole();
+        QCoreApplication a(argc, argv);
+        WallpaperFetcher fetcher;
+        QObject::connect(&fetcher, &WallpaperFetcher::archiveIndexProgress, [](const QString &yearMonth, bool ok) {
+            std::printf("%s %s\n", qPrintable(yearMonth), ok ? "ok" : "failed");
+        });
+        QObject::connect(&fetcher, &WallpaperFetcher::archiveIndexBuilt, &a, [](int dayCount) {
+            std::printf("archive index: %d days\n", dayCount);
+            QCoreApplication::quit();
+        });
+        QMetaObject::invokeMethod(&fetcher, &WallpaperFetcher::buildArchiveIndex, Qt::QueuedConnection);
+        return a.exec();
+    }
+
+    if (mode == "--sync" || mode == "--save-range") {
+        attachParentConsole();
+        QCoreApplication a(argc, argv);
+        return runSync(a, mode == "--save-range" ? QDir::home().filePath("Pictures/MyBingWallpaper") : QString());
+    }
+
+    if (mode == "--apply-today" || mode == "--apply-date" || mode == "--random") {
+        attachParentConsole();
+        QCoreApplication a(argc, argv);
+        return runApply(a, mode);
+    }
+
     QApplication a(argc, argv);
     MainWindow w;
     return a.exec();
@@ -3,13 +3,30 @@
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::MainWindow)
-    , networkManager(new QNetworkAccessManager(this)) 
+    , fetcher(new WallpaperFetcher(this))
+    , prefetcher(new Prefetcher(fetcher, this))
+    , imageExecutor(new ImageExecutor(this))
+    , previewDecoder(new PreviewDecoder(imageExecutor, this))
+    , imageIndexer(new ImageIndexer(fetcher, imageExecutor, this))
 {
     ui->setupUi(this);
     setWindowTitle(tr("必应壁纸"));
 
     ui->label_2->setTextInteractionFlags(Qt::TextSelectableByMouse);
 
+    // 右击预览图查找相似的壁纸
+    ui->label->setContextMenuPolicy(Qt::CustomContextMenu);
+    connect(ui->label, &QWidget::customContextMenuRequested, this, &MainWindow::showPreviewMenu);
+
+    // 输入时即时搜索壁纸标题，结果列表盖在日历上方
+    ui->searchResults->hide();
+    connect(ui->searchEdit, &QLineEdit::textChanged, this, &MainWindow::searchTitles);
+    connect(ui->searchEdit, &QLineEdit::returnPressed, this, [this]() {
+        openSearchResult(ui->searchResults->item(0));
+    });
+    connect(ui->searchResults, &QListWidget::itemActivated, this, &MainWindow::openSearchResult);
+    connect(ui->searchResults, &QListWidget::itemClicked, this, &MainWindow::openSearchResult);
+
     // 设置日历最大日期为今天，限制不能选择未来日期
     updateCalendarMaximumDate();
     QTextCharFormat weekendFormat;
@@ -17,12 +34,27 @@ MainWindow::MainWindow(QWidget *parent)
     ui->calendarWidget->setWeekdayTextFormat(Qt::Saturday, weekendFormat);
     ui->calendarWidget->setWeekdayTextFormat(Qt::Sunday, weekendFormat);
     
-    // Set window icon
-    setWindowIcon(getApplicationIcon());
+    // 窗口和托盘共用同一图标，只生成一次
+    appIcon = getApplicationIcon();
+    setWindowIcon(appIcon);
+
+    // 异步获取壁纸信息、预览图和原图
+    connect(fetcher, &WallpaperFetcher::metadataReady, this, &MainWindow::onMetadataReady);
+    connect(fetcher, &WallpaperFetcher::previewReady, this, &MainWindow::onPreviewReady);
+    connect(fetcher, &WallpaperFetcher::imageReady, this, &MainWindow::onImageReady);
+    connect(fetcher, &WallpaperFetcher::failed, this, &MainWindow::onFetchFailed);
+    connect(previewDecoder, &PreviewDecoder::decoded, this, &MainWindow::onPreviewDecoded);
+
+    // 翻页时在后台预取该月的壁纸信息和预览图
+    connect(ui->calendarWidget, &QCalendarWidget::currentPageChanged, this, [this](int year, int month) {
+        prefetcher->prefetchAround(ui->calendarWidget->selectedDate(), year, month);
+    });
 
-    // 初始化自动更新定时器
-    updateTimer = new QTimer(this);
-    connect(updateTimer, &QTimer::timeout, this, &MainWindow::autoUpdateWallpaper);
+    // 初始化每日更新计划
+    updateScheduler = new UpdateScheduler(this);
+    connect(updateScheduler, &UpdateScheduler::due, this, &MainWindow::autoUpdateWallpaper);
+    // 隐藏在托盘时也需要窗口句柄接收睡眠唤醒和时间变化通知
+    winId();
 
     // 先加载设置
     loadSettings();
@@ -30,15 +62,24 @@ MainWindow::MainWindow(QWidget *parent)
     // 检查网络连接并加载主界面壁纸
     initNetworkWallpaper();
 
+    // 启动完成后在后台为已下载的壁纸建立感知哈希索引，并补全标题索引
+    QTimer::singleShot(10000, imageIndexer, &ImageIndexer::indexArchive);
+    QTimer::singleShot(10000, fetcher, &WallpaperFetcher::updateTitleIndex);
+
     // 再创建托盘图标（使用加载的设置）
     createTrayIcon();
+
+    // 开机自启时窗口不显示，同样在空闲后释放内存
+    idleTrimTimer.setSingleShot(true);
+    idleTrimTimer.setInterval(30000);
+    connect(&idleTrimTimer, &QTimer::timeout, this, &MainWindow::trimIdleMemory);
+    if (!isVisible()) {
+        idleTrimTimer.start();
+    }
 }
 
 MainWindow::~MainWindow()
 {
-    if (updateTimer->isActive()) {
-        updateTimer->stop();
-    }
     delete ui;
 }
 
@@ -67,11 +108,18 @@ void MainWindow::loadSettings()
     else if (shouldAutoStart && !currentlyAutoStart) {
         setAutoStart(true);
     }
+    // 供createTrayIcon使用，不再重复读取注册表
+    autoStartEnabled = shouldAutoStart;
     
     // 保存各种设置项，供createTrayIcon使用
     shouldAutoUpdate = settings.value("autoUpdate", false).toBool();
     lockscreenEnabled = settings.value("setLockScreenWallpaper_enabled", false).toBool();
     lastSelectedDate = settings.value("lastSelectedDate", "").toString();
+
+    // 原图分段并行下载的段数，设为1则不分段
+    fetcher->setImageSegments(settings.value("downloadSegments", 4).toInt());
+    // 月度json的镜像根目录列表，未设置时使用默认镜像
+    fetcher->setMetadataMirrors(settings.value("metadataMirrors").toStringList());
 }
 
 void MainWindow::saveSettings(const QString &key, const QVariant &value)
@@ -82,52 +130,26 @@ void MainWindow::saveSettings(const QString &key, const QVariant &value)
 
 void MainWindow::initNetworkWallpaper()
 {
-    // 创建网络连接检查定时器
-    QTimer *networkCheckTimer = new QTimer(this);
-    
-    // 定义网络检查函数对象
-    auto checkNetworkConnection = [this, networkCheckTimer]() {
-        // 创建测试网络请求
-        QNetworkRequest request(QUrl("https://www.bing.com"));
-        QNetworkReply *testReply = networkManager->head(request);
-        
-        // 创建一个事件循环等待网络请求完成
-        QEventLoop loop;
-        connect(testReply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
-        loop.exec();
-        
-        bool isConnected = (testReply->error() == QNetworkReply::NoError);
-        testReply->deleteLater();
-        
-        if (isConnected) {
-            if (shouldAutoUpdate || lastSelectedDate.isEmpty()) {
-                QDate currentDate = QDate::currentDate();
-                setSelectedDateWithAutoClick(currentDate.toString("yyyyMMdd"), true);
-            } else {
-                setSelectedDateWithAutoClick(lastSelectedDate, false);
-            }
+    // 网络可用后加载主界面壁纸；离线时等待系统通知，不再定时轮询
+    ConnectivityWatcher *connectivity = new ConnectivityWatcher(fetcher->network(), fetcher->metadataHostUrl(), this);
 
-            networkCheckTimer->stop();
-            networkCheckTimer->deleteLater();
+    connect(connectivity, &ConnectivityWatcher::waiting, this, [this]() {
+        ui->label_2->setText(tr("等待网络连接..."));
+    });
 
-            // qDebug() << "Network connection established";
+    connect(connectivity, &ConnectivityWatcher::online, this, [this, connectivity]() {
+        // 获取壁纸信息的同时建立到图片服务器的连接
+        fetcher->warmConnections();
+        if (shouldAutoUpdate || lastSelectedDate.isEmpty()) {
+            QDate currentDate = QDate::currentDate();
+            setSelectedDateWithAutoClick(currentDate.toString("yyyyMMdd"), true);
         } else {
-            // 网络连接失败，继续等待
-            ui->label_2->setText(tr("等待网络连接..."));
-            // qDebug() << "Waiting for network connection...";
+            setSelectedDateWithAutoClick(lastSelectedDate, false);
         }
-        
-        return isConnected;
-    };
-    
-    // 连接槽函数，每次定时器触发时检查网络
-    connect(networkCheckTimer, &QTimer::timeout, this, checkNetworkConnection);
-    
-    // 启动定时器，每5秒检查一次网络连接
-    networkCheckTimer->start(5000);
-    
-    // 立即进行一次检查
-    QTimer::singleShot(0, this, checkNetworkConnection);
+        connectivity->deleteLater();
+    });
+
+    connectivity->start();
 }
 
 void MainWindow::createTrayIcon()
@@ -143,18 +165,18 @@ void MainWindow::createTrayIcon()
     connect(dailyUpdateAction, &QAction::triggered, this, [this]() {
         shouldAutoUpdate = dailyUpdateAction->isChecked();
         if (shouldAutoUpdate) {
-            resetUpdateTimer();
+            updateScheduler->start(QDate::fromString(lastSelectedDate, "yyyyMMdd"));
             QDate currentDate = QDate::currentDate();
             if (lastSelectedDate.isEmpty() || lastSelectedDate != currentDate.toString("yyyyMMdd")) {
                 setSelectedDateWithAutoClick(currentDate.toString("yyyyMMdd"), true);
             }
         } else {
-            updateTimer->stop();
+            updateScheduler->stop();
         }
         saveSettings("autoUpdate", shouldAutoUpdate);
     });
     if (shouldAutoUpdate) {
-        resetUpdateTimer();
+        updateScheduler->start(QDate::fromString(lastSelectedDate, "yyyyMMdd"));
     }
 
     // Create lockscreen action
@@ -189,10 +211,12 @@ void MainWindow::createTrayIcon()
         setAutoStart(checked);
         saveSettings("autoStart", checked);
     });
-    autoStartAction->setChecked(isAutoStartEnabled());
+    autoStartAction->setChecked(autoStartEnabled);
 
     // Create tray icon menu
     trayIconMenu = new QMenu(this);
+    trayIconMenu->addAction(tr("全部壁纸"), this, &MainWindow::showMonthOverview);
+    trayIconMenu->addSeparator();
     trayIconMenu->addAction(dailyUpdateAction);
     trayIconMenu->addAction(lockscreenAction);
     trayIconMenu->addAction(autoStartAction);
@@ -204,7 +228,7 @@ void MainWindow::createTrayIcon()
     trayIcon->setContextMenu(trayIconMenu);
 
     // Set tray icon using the application icon
-    trayIcon->setIcon(getApplicationIcon());
+    trayIcon->setIcon(appIcon);
     trayIcon->setToolTip(tr("MyBingWallpaper"));
     trayIcon->show();
 
@@ -224,6 +248,8 @@ void MainWindow::autoUpdateWallpaper()
     // 如果当前日期与上次选择的日期不一致，则设置日历控件的日期为当前日期
     if (lastSelectedDate != currentDateStr) {
         setSelectedDateWithAutoClick(currentDateStr, true);
+    } else {
+        updateScheduler->applied(currentDate);
     }
 }
 
@@ -238,186 +264,254 @@ void MainWindow::on_calendarWidget_selectionChanged()
 void MainWindow::setSelectedDateWithAutoClick(const QString &date, bool autoClick)
 {
     if (ui->calendarWidget->selectedDate().toString("yyyyMMdd") != date) {
+        // 阻止selectionChanged重复发起同一日期的请求
+        const QSignalBlocker blocker(ui->calendarWidget);
         ui->calendarWidget->setSelectedDate(QDate::fromString(date, "yyyyMMdd"));
     }
-    bool success = setNetworkPic_json(date);
-    if (success && autoClick) {
+    needAutoClickAfterSelection = autoClick;
+    setNetworkPic_json(date);
+    if (monthOverview && monthOverview->isVisible()) {
+        monthOverview->setSelectedDate(QDate::fromString(date, "yyyyMMdd"));
+    }
+
+    // 前台请求完成后预取相邻日期和当前显示的月份
+    prefetcher->prefetchAround(ui->calendarWidget->selectedDate(),
+                               ui->calendarWidget->yearShown(), ui->calendarWidget->monthShown());
+}
+
+void MainWindow::setNetworkPic_json(const QString &date)
+{
+    // 只处理最后一次选择的日期，旧请求由fetcher取消
+    pendingDate = date;
+    fetcher->fetchMetadata(date);
+    updateBusyState();
+}
+
+void MainWindow::onMetadataReady(const QString &date, const QString &imgtitle, const QString &imgurl)
+{
+    if (date != pendingDate) {
+        return;
+    }
+
+    currentImgUrl = imgurl;
+    ui->label_2->setText(imgtitle);
+    ui->label_2->adjustSize();
+    setNetworkPic(currentImgUrl);
+
+    if (needAutoClickAfterSelection) {
+        needAutoClickAfterSelection = false;
         on_pushButton_clicked();
     }
+    updateBusyState();
 }
 
-bool MainWindow::setNetworkPic_json(const QString &date)
+void MainWindow::setNetworkPic(const QString &imgurl)
 {
-    // Disable UI components
-    disableUI();
-    // 从日期字符串提取年月信息，用于构建月度文件路径
-    QString yearMonth = date.left(6); // 从yyyyMMdd格式的日期中获取yyyyMM部分
-    
-    // 读取月度JSON文件URL
-    QString jsonurl = "https://my-bing-wallpaper.oss-cn-beijing.aliyuncs.com/month/"+yearMonth+".json";
-    QUrl url(jsonurl);
-    QNetworkRequest request(url);
-    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
-    
-    QEventLoop loop;
-    QTimer timer;
-    
-    // 设置超时时间为3秒
-    timer.setSingleShot(true);
-    timer.start(3000);
-    
-    QNetworkReply *reply = networkManager->get(request);
-    
-    // 连接超时信号和完成信号
-    connect(&timer, &QTimer::timeout, [&loop, reply]() {
-        reply->abort();
-        loop.quit();
-    });
-    
-    // Connect to exit the event loop when finished
-    connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
-    
-    // Start the event loop
-    loop.exec();
-    
-    // 判断是否超时
-    bool isTimeout = !timer.isActive();
-    if (!isTimeout) {
-        // 未超时，停止计时器
-        timer.stop();
+    // 内存中已有缩放好的预览图时直接显示
+    QPixmap cached = fetcher->previewCache()->pixmap(imgurl);
+    if (!cached.isNull()) {
+        fetcher->cancel(WallpaperFetcher::PreviewStage);
+        ui->label->setPixmap(cached);
+        rememberPreviewFeatures(imgurl, cached.toImage());
+        return;
     }
-    
-    bool success = false;
-    
-    if (isTimeout) {
-        ui->label_2->setText(tr("获取壁纸信息超时"));
-        ui->label_2->adjustSize();
-        resetNetworkManager(); // 重置网络管理器
-    } else if (reply->error() != QNetworkReply::NoError) {
-        ui->label_2->setText(tr("网络请求失败: ") + reply->errorString());
-        ui->label_2->adjustSize();
-        resetNetworkManager(); // 重置网络管理器
-    } else {
-        QByteArray jsonData = reply->readAll();
-        QJsonDocument jsonDoc = QJsonDocument::fromJson(jsonData);
-        
-        if (!jsonDoc.isNull()) {
-            if (jsonDoc.isObject()) {
-                // 处理月度JSON文件，这是一个包含多个日期的对象
-                QJsonObject monthObj = jsonDoc.object();
-                
-                // 查找特定日期的数据
-                if (monthObj.contains(date)) {
-                    // 获取特定日期的数据
-                    QJsonObject dayObj = monthObj[date].toObject();
-                    
-                    QString imgtitle = dayObj["imgtitle"].toString();
-                    currentImgUrl = dayObj["imgurl"].toString();
-                    
-                    if (!imgtitle.isEmpty() && !currentImgUrl.isEmpty()) {
-                        ui->label_2->setText(imgtitle);
-                        ui->label_2->adjustSize();
-                        setNetworkPic(currentImgUrl);
-                        success = true;
-                    } else {
-                        ui->label_2->setText(tr("获取图片信息失败"));
-                    }
-                } else {
-                    ui->label_2->setText(tr("未找到该日期壁纸数据"));
-                }
-            } else {
-                ui->label_2->setText(tr("JSON格式不支持"));
-            }
-        } else {
-            ui->label_2->setText(tr("JSON数据解析失败"));
-        }
+
+    // 原图已下载时直接从原图生成预览，不再下载预览图
+    QString storedPath = fetcher->imageStore()->find(imgurl);
+    if (!storedPath.isEmpty()) {
+        fetcher->cancel(WallpaperFetcher::PreviewStage);
+        previewDecoder->decodeFile(imgurl, storedPath, ui->label->size());
+        return;
+    }
+    fetcher->fetchPreview(imgurl);
+}
+
+void MainWindow::onPreviewReady(const QString &imgurl, const QByteArray &data)
+{
+    if (imgurl != currentImgUrl) {
+        return;
     }
 
-    // 确保彻底释放网络资源
-    reply->disconnect();
-    reply->deleteLater();
-    
-    // Re-enable UI components
-    enableUI();
-    return success;
+    // 在工作线程中按显示尺寸解码
+    previewDecoder->decode(imgurl, data, ui->label->size());
 }
 
-void MainWindow::setNetworkPic(const QString &imgurl)
+void MainWindow::onPreviewDecoded(const QString &imgurl, const QImage &image)
 {
-    QUrl url;
-    if (imgurl.contains("bing.com")) {
-        url = QUrl(imgurl+"&w=480");
-    } else {
-        url = QUrl(imgurl);
+    if (imgurl != currentImgUrl || image.isNull()) {
+        return;
     }
-    QEventLoop loop;
-    QTimer timer;
-    
-    // 设置超时时间为5秒
-    timer.setSingleShot(true);
-    timer.start(5000);
 
-    QNetworkRequest request(url);
-    QNetworkReply *reply = networkManager->get(request);
-    
-    // 连接超时信号和完成信号
-    connect(&timer, &QTimer::timeout, [&loop, reply]() {
-        reply->abort();
-        loop.quit();
+    QPixmap dest = QPixmap::fromImage(image);
+    ui->label->setPixmap(dest);
+    fetcher->previewCache()->insertPixmap(imgurl, dest);
+    rememberPreviewFeatures(imgurl, image);
+    // 隐藏时的每日更新也会解码预览图，之后再释放一次
+    if (!isVisible()) {
+        idleTrimTimer.start();
+    }
+}
+
+void MainWindow::rememberPreviewFeatures(const QString &imgurl, const QImage &image)
+{
+    previewHashUrl = imgurl;
+    previewHash = PerceptualIndex::imageHash(image);
+    previewColors = ColorIndex::imageSignature(image);
+}
+
+void MainWindow::addDateAction(QMenu *menu, const QDate &date, const QString &suffix, const QColor &swatch)
+{
+    QString text = date.toString("yyyy-MM-dd");
+    QString imgtitle, imgurl;
+    if (fetcher->cachedMetadata(date.toString("yyyyMMdd"), &imgtitle, &imgurl)) {
+        text += "  " + imgtitle.section(QChar(0xff08), 0, 0).section(" (", 0, 0);
+    }
+    QAction *action = menu->addAction(text + suffix);
+    if (swatch.isValid()) {
+        QPixmap pixmap(12, 12);
+        pixmap.fill(swatch);
+        action->setIcon(QIcon(pixmap));
+    }
+    connect(action, &QAction::triggered, this, [this, date]() {
+        setSelectedDateWithAutoClick(date.toString("yyyyMMdd"), false);
     });
-    connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
-    
-    // 开启事件循环
-    loop.exec();
-    
-    // 判断是否超时
-    bool isTimeout = !timer.isActive();
-    if (!isTimeout) {
-        // 未超时，停止计时器
-        timer.stop();
-    }
-
-    // 在超时情况下处理
-    if (isTimeout || reply->error() != QNetworkReply::NoError) {
-        QString errorMsg = isTimeout ? 
-            tr("预览图片下载超时") : 
-            tr("预览图片下载失败: ") + reply->errorString();
-        
-        ui->label_2->setText(errorMsg);
-        ui->label_2->adjustSize();
-        
-        // 确保彻底释放网络资源
-        reply->disconnect();
-        reply->deleteLater();
-        
-        // 重置网络管理器
-        resetNetworkManager();
+}
+
+void MainWindow::showColorMatches(const QColor &color, const QPoint &globalPos)
+{
+    QMenu menu(this);
+    const QList<ColorIndex::Match> matches = fetcher->colorIndex()->nearest(color, 12, ui->calendarWidget->selectedDate());
+    if (matches.isEmpty()) {
+        menu.addAction(tr("没有已下载的壁纸"))->setEnabled(false);
+    }
+    for (const ColorIndex::Match &match : matches) {
+        ColorIndex::Signature signature;
+        fetcher->colorIndex()->signature(match.date, &signature);
+        addDateAction(&menu, match.date, QString(), QColor::fromRgb(signature.dominant[0]));
+    }
+    menu.exec(globalPos);
+}
+
+void MainWindow::showPreviewMenu(const QPoint &pos)
+{
+    QMenu menu(this);
+    const bool hasFeatures = previewHashUrl == currentImgUrl;
+    const QPoint globalPos = ui->label->mapToGlobal(pos);
+
+    // 只在已下载的壁纸中查找
+    QMenu *similarMenu = menu.addMenu(tr("相似壁纸"));
+    QList<PerceptualIndex::Match> matches;
+    if (hasFeatures) {
+        matches = fetcher->perceptualIndex()->similar(previewHash, PerceptualIndex::SimilarDistance, 10,
+                                                      ui->calendarWidget->selectedDate());
+    }
+    if (matches.isEmpty()) {
+        similarMenu->addAction(tr("没有找到相似的壁纸"))->setEnabled(false);
+    }
+    for (const PerceptualIndex::Match &match : std::as_const(matches)) {
+        addDateAction(similarMenu, match.date,
+                      match.distance <= PerceptualIndex::DuplicateDistance ? tr(" (相同)") : QString());
+    }
+
+    // 以当前壁纸的主色查找，或自选颜色
+    QColor mainColor = hasFeatures && previewColors.dominantShare[0] > 0 ? QColor::fromRgb(previewColors.dominant[0]) : QColor();
+    QAction *sameColorAction = menu.addAction(tr("颜色相近的壁纸"));
+    sameColorAction->setEnabled(mainColor.isValid());
+    if (mainColor.isValid()) {
+        QPixmap pixmap(12, 12);
+        pixmap.fill(mainColor);
+        sameColorAction->setIcon(QIcon(pixmap));
+    }
+    QAction *pickColorAction = menu.addAction(tr("按颜色查找..."));
+    menu.addSeparator();
+    menu.addAction(tr("全部壁纸..."), this, &MainWindow::showMonthOverview);
+
+    QAction *chosen = menu.exec(globalPos);
+    if (chosen == sameColorAction) {
+        showColorMatches(mainColor, globalPos);
+    } else if (chosen == pickColorAction) {
+        QColor color = QColorDialog::getColor(mainColor.isValid() ? mainColor : QColor(Qt::white), this, tr("选择颜色"));
+        if (color.isValid()) {
+            showColorMatches(color, globalPos);
+        }
+    }
+}
+
+void MainWindow::searchTitles(const QString &text)
+{
+    ui->searchResults->clear();
+    if (text.trimmed().isEmpty()) {
+        ui->searchResults->hide();
         return;
     }
 
-    QByteArray jpegData = reply->readAll();
-    QPixmap pixmap;
-    pixmap.loadFromData(jpegData);
-    QPixmap dest=pixmap.scaled(ui->label->size(),Qt::KeepAspectRatio,Qt::SmoothTransformation);
-    ui->label->setPixmap(dest);
-    
-    // 确保彻底释放网络资源
-    reply->disconnect();
-    reply->deleteLater();
+    const QList<TitleIndex::Match> matches = fetcher->titleIndex()->search(text, 50);
+    for (const TitleIndex::Match &match : matches) {
+        QString imgtitle, imgurl;
+        fetcher->cachedMetadata(match.date.toString("yyyyMMdd"), &imgtitle, &imgurl);
+        QListWidgetItem *item = new QListWidgetItem(match.date.toString("yyyy-MM-dd") + "  " + imgtitle, ui->searchResults);
+        item->setData(Qt::UserRole, match.date);
+        item->setToolTip(imgtitle);
+    }
+    if (matches.isEmpty()) {
+        ui->searchResults->addItem(tr("没有找到"));
+        ui->searchResults->item(0)->setFlags(Qt::NoItemFlags);
+    }
+    ui->searchResults->show();
+    ui->searchResults->raise();
+}
+
+void MainWindow::openSearchResult(QListWidgetItem *item)
+{
+    // 单击和激活可能同时触发，只处理一次
+    if (!item || !item->data(Qt::UserRole).isValid() || ui->searchResults->isHidden()) {
+        return;
+    }
+    ui->searchResults->hide();
+    setSelectedDateWithAutoClick(item->data(Qt::UserRole).toDate().toString("yyyyMMdd"), false);
+}
+
+void MainWindow::showMonthOverview()
+{
+    if (!monthOverview) {
+        monthOverview = new MonthOverview(fetcher, imageExecutor, this);
+        monthOverview->setWindowFlag(Qt::Window);
+        monthOverview->setWindowIcon(appIcon);
+        connect(monthOverview, &MonthOverview::dateActivated, this, [this](const QDate &date) {
+            setSelectedDateWithAutoClick(date.toString("yyyyMMdd"), false);
+        });
+    }
+    monthOverview->show();
+    monthOverview->raise();
+    monthOverview->activateWindow();
+    monthOverview->setSelectedDate(ui->calendarWidget->selectedDate());
+}
+
+void MainWindow::onFetchFailed(WallpaperFetcher::Stage stage, const QString &message)
+{
+    ui->label_2->setText(message);
+    ui->label_2->adjustSize();
+
+    if (stage == WallpaperFetcher::MetadataStage) {
+        needAutoClickAfterSelection = false;
+    } else if (stage == WallpaperFetcher::ImageStage) {
+        pendingImageAction = NoImageAction;
+    }
+    // 每日更新没有取到新壁纸(如当月文件未变化)时退避重试
+    if (stage != WallpaperFetcher::PreviewStage) {
+        updateScheduler->retryLater();
+    }
+    updateBusyState();
 }
 
 void MainWindow::on_pushButton_clicked()
 {
-    disableUI();
     downloadAndSetWallpaper();
-    enableUI();
 }
 
 void MainWindow::on_pushButton_2_clicked()
 {
-    disableUI();
     downloadAndSaveWallpaper();
-    enableUI();
 }
 
 void MainWindow::on_pushButton_3_clicked()
@@ -427,31 +521,54 @@ void MainWindow::on_pushButton_3_clicked()
 
 void MainWindow::downloadAndSetWallpaper()
 {
-    if (!downloadImage()) {
-        return;
-    }
-
-    // 设置为壁纸
-    bool desktopResult = setWindowsWallpaper(currentImgPath);
-    
-    // If lock screen wallpaper is enabled, set it directly too
-    if (lockscreenEnabled && desktopResult) {
-        setLockScreenWallpaper(currentImgPath);
-    }
-    
-    // Save the currently selected date
-    lastSelectedDate = ui->calendarWidget->selectedDate().toString("yyyyMMdd");
-    saveSettings("lastSelectedDate", lastSelectedDate);
+    pendingImageAction = ApplyImage;
+    pendingImageDate = ui->calendarWidget->selectedDate();
+    downloadImage();
 }
 
 void MainWindow::downloadAndSaveWallpaper()
 {
-    if (!downloadImage()) {
-        return;
-    }
+    pendingImageAction = SaveImage;
+    pendingImageDate = ui->calendarWidget->selectedDate();
+    downloadImage();
+}
+
+void MainWindow::applyDownloadedWallpaper()
+{
+    QString imagePath = currentImgPath;
+    QDate imageDate = pendingImageDate;
+    QList<DesktopMonitor> monitors = desktopMonitors();
+
+    // 在线程池中按各显示器的分辨率生成壁纸
+    WallpaperRenderer renderer = wallpaperRenderer;
+    imageExecutor->run<QStringList>(ImageExecutor::ForegroundPriority, this, [renderer, imagePath, monitors]() {
+        return renderer.renderAll(imagePath, monitors);
+    }, [this, imagePath, imageDate, monitors](QStringList renditions) {
+        // 设置为壁纸，无法逐个显示器设置时所有显示器使用原图
+        bool desktopResult = setMonitorWallpapers(monitors, renditions) || setDesktopWallpaper(imagePath);
+
+        // If lock screen wallpaper is enabled, set it directly too
+        if (lockscreenEnabled && desktopResult) {
+            setLockScreenWallpaper(imagePath);
+        }
+
+        // Save the date the download was started for
+        lastSelectedDate = imageDate.toString("yyyyMMdd");
+        saveSettings("lastSelectedDate", lastSelectedDate);
+        updateScheduler->applied(imageDate);
 
-    // Get current date for filename
-    QString dateStr = ui->calendarWidget->selectedDate().toString("yyyy-MM-dd");
+        // 记录启动后首次设置壁纸的耗时，与无界面模式对比
+        if (!startupReported) {
+            startupReported = true;
+            qInfo() << "wallpaper applied in" << msecsSinceProcessStart() << "ms after process start";
+        }
+    });
+}
+
+void MainWindow::saveDownloadedWallpaper()
+{
+    // Get download date for filename
+    QString dateStr = pendingImageDate.toString("yyyy-MM-dd");
 
     // Get user's Pictures directory path
     QString savePath = QDir::home().filePath("Pictures/MyBingWallpaper");
@@ -465,15 +582,24 @@ void MainWindow::downloadAndSaveWallpaper()
     // 最终文件名
     QString finalFilePath = dir.filePath(QString("%1.jpg").arg(dateStr));
     
-    // Copy the temporary file to the Pictures directory
-    QFile::copy(currentImgPath, finalFilePath);
+    // 从存储中reflink或硬链接到图片文件夹，不复制数据；已存在时替换
+    // 比较已有文件的哈希可能较慢，在线程池中进行
+    QString sourcePath = currentImgPath;
+    imageExecutor->run<bool>(ImageExecutor::ForegroundPriority, this, [sourcePath, finalFilePath]() {
+        return ImageStore::place(sourcePath, finalFilePath);
+    }, [this, finalFilePath](bool saved) {
+        if (!saved) {
+            QMessageBox::warning(this, tr("警告"), tr("图片保存失败:\n%1").arg(finalFilePath));
+            return;
+        }
 
-    QMessageBox msgBox;
-    msgBox.setWindowTitle(tr("成功"));
-    msgBox.setText(tr("图片已保存至:\n%1").arg(finalFilePath));
-    msgBox.setTextInteractionFlags(Qt::TextSelectableByMouse);
-    msgBox.setIcon(QMessageBox::Information);
-    msgBox.exec();
+        QMessageBox msgBox;
+        msgBox.setWindowTitle(tr("成功"));
+        msgBox.setText(tr("图片已保存至:\n%1").arg(finalFilePath));
+        msgBox.setTextInteractionFlags(Qt::TextSelectableByMouse);
+        msgBox.setIcon(QMessageBox::Information);
+        msgBox.exec();
+    });
 }
 
 void MainWindow::randomUpdateWallpaper()
@@ -485,93 +611,30 @@ void MainWindow::randomUpdateWallpaper()
     
     // 设置日历控件的日期
     setSelectedDateWithAutoClick(randomDate.toString("yyyyMMdd"), true);
-
-    // Save the currently selected date
-    lastSelectedDate = ui->calendarWidget->selectedDate().toString("yyyyMMdd");
-    saveSettings("lastSelectedDate", lastSelectedDate);
 }
 
-bool MainWindow::downloadImage()
+void MainWindow::downloadImage()
 {
-    updateTimer->stop();
-    
-    QUrl url(currentImgUrl);
-    QEventLoop loop;
-    QTimer timer;
-    
-    // 设置超时时间
-    timer.setSingleShot(true);
-    timer.start(8000);
+    // 已存储的图片会立即返回，不访问网络；感知哈希得到的别名不算，用户下载时总是取原图
+    fetcher->fetchImage(currentImgUrl);
+    updateBusyState();
+}
 
-    QNetworkRequest request(url);
-    QNetworkReply *reply = networkManager->get(request);
-    
-    // 连接超时信号和完成信号
-    connect(&timer, &QTimer::timeout, [&loop, reply]() {
-        reply->abort();
-        loop.quit();
-    });
-    connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
-    
-    // 开启事件循环
-    loop.exec();
-    
-    // 判断是否超时
-    bool isTimeout = !timer.isActive();
-    if (!isTimeout) {
-        // 未超时，停止计时器
-        timer.stop();
-    }
-
-    // 在超时或错误情况下处理
-    if (isTimeout || reply->error() != QNetworkReply::NoError) {
-        QString errorMsg = isTimeout ? 
-            tr("下载壁纸超时: ") + url.toString() : 
-            tr("下载壁纸失败: ") + reply->errorString();
-        
-        ui->label_2->setText(errorMsg);
-        ui->label_2->adjustSize();
-        
-        // 确保彻底释放网络资源
-        reply->disconnect();
-        reply->deleteLater();
-        
-        // 重置网络管理器
-        resetNetworkManager();
-        resetUpdateTimer();
-        return false;
-    }
-
-    QByteArray jpegData = reply->readAll();
-    QString finalPath = QDir::tempPath() + "/mybingwallpaper.jpg";
-    QFile file(finalPath);
-    if (file.open(QIODevice::WriteOnly)) {
-        file.write(jpegData);
-        file.close();
-        currentImgPath = finalPath;
-    } else {
-        ui->label_2->setText(tr("无法保存壁纸到临时文件!"));
-        // 确保彻底释放网络资源
-        reply->disconnect();
-        reply->deleteLater();
-        resetNetworkManager();
-        resetUpdateTimer();
-        return false;
+void MainWindow::onImageReady(const QString &imgurl, const QString &filePath)
+{
+    Q_UNUSED(imgurl);
+    currentImgPath = filePath;
+    if (pendingImageDate.isValid() && !imageIndexer->isIndexed(pendingImageDate)) {
+        imageIndexer->add(pendingImageDate, filePath);
     }
 
-    // 确保彻底释放网络资源
-    reply->disconnect();
-    reply->deleteLater();
+    ImageAction action = pendingImageAction;
+    pendingImageAction = NoImageAction;
+    updateBusyState();
 
-    resetUpdateTimer();
-    return true;
-}
-
-void MainWindow::resetNetworkManager()
-{
-    if (networkManager) {
-        networkManager->deleteLater();
+    if (action == ApplyImage) {
+        applyDownloadedWallpaper();
+    } else if (action == SaveImage) {
+        saveDownloadedWallpaper();
     }
-    
-    networkManager = new QNetworkAccessManager(this);
 }
@@ -2,6 +2,16 @@
 #define MAINWINDOW_H
 
 #include "ui_mainwindow.h"
+#include "wallpaperfetcher.h"
+#include "prefetcher.h"
+#include "connectivitywatcher.h"
+#include "updatescheduler.h"
+#include "previewdecoder.h"
+#include "imageexecutor.h"
+#include "imageindexer.h"
+#include "wallpaperrenderer.h"
+#include "monthoverview.h"
+#include "platform.h"
 #include <QMainWindow>
 #include <QString>
 #include <QtNetwork/QNetworkAccessManager>
@@ -32,9 +42,16 @@
 #include <QDebug>
 #include <QFile>
 #include <QMoveEvent>
+#include <QShowEvent>
+#include <QHideEvent>
 #include <QDateTime>
 #include <QJsonArray>
 #include <QRandomGenerator>
+#include <QSignalBlocker>
+#include <QPointer>
+#include <QColorDialog>
+#include <QPixmapCache>
+#include <QListWidget>
 
 QT_BEGIN_NAMESPACE
 namespace Ui {
@@ -53,6 +70,9 @@ public:
 protected:
     void closeEvent(QCloseEvent *event) override;
     void moveEvent(QMoveEvent *event) override;
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+    bool nativeEvent(const QByteArray &eventType, void *message, qintptr *result) override;
 
 private slots:
     void on_pushButton_clicked();
@@ -63,44 +83,74 @@ private slots:
     void exitApplication();
     void autoUpdateWallpaper();
     void randomUpdateWallpaper();
+    void onMetadataReady(const QString &date, const QString &imgtitle, const QString &imgurl);
+    void onPreviewReady(const QString &imgurl, const QByteArray &data);
+    void onPreviewDecoded(const QString &imgurl, const QImage &image);
+    void onImageReady(const QString &imgurl, const QString &filePath);
+    void onFetchFailed(WallpaperFetcher::Stage stage, const QString &message);
+    void showPreviewMenu(const QPoint &pos);
+    void searchTitles(const QString &text);
+    void openSearchResult(QListWidgetItem *item);
+    void showMonthOverview();
 
 private:
     Ui::MainWindow *ui;
-    QNetworkAccessManager *networkManager;
+    WallpaperFetcher *fetcher;
+    Prefetcher *prefetcher;
+    ImageExecutor *imageExecutor;
+    PreviewDecoder *previewDecoder;
+    ImageIndexer *imageIndexer;
+    MonthOverview *monthOverview = nullptr;  // 首次打开时创建
+    WallpaperRenderer wallpaperRenderer;
     QString const configPath = QApplication::applicationDirPath() + "/mybing.conf";
     QString currentImgUrl;
     QString currentImgPath;
+    // 当前显示的预览图的特征：感知哈希用于查找相似壁纸，颜色用于按颜色浏览
+    QString previewHashUrl;
+    quint64 previewHash = 0;
+    ColorIndex::Signature previewColors = {};
     QProgressDialog *loadingDialog = nullptr;
     bool needAutoClickAfterSelection = false;
     bool needSelectDateAndAutoClick = false;
+    QString pendingDate;
+    enum ImageAction {
+        NoImageAction,
+        ApplyImage,
+        SaveImage
+    };
+    ImageAction pendingImageAction = NoImageAction;
+    QDate pendingImageDate;
     QString lastSelectedDate;
     bool shouldAutoUpdate = false;
     bool lockscreenEnabled = false;
+    bool autoStartEnabled = false;
+    bool startupReported = false;
+    QIcon appIcon;
     void setSelectedDateWithAutoClick(const QString &date, bool autoClick);
-    bool setWindowsWallpaper(const QString &imagePath);
-    bool setLockScreenWallpaper(const QString &imagePath);
-    bool clearLockScreenWallpaper();
-    bool setNetworkPic_json(const QString &date);
+    void setNetworkPic_json(const QString &date);
     void setNetworkPic(const QString &imgurl);
     QIcon getApplicationIcon();
-    void resetNetworkManager();
+    void rememberPreviewFeatures(const QString &imgurl, const QImage &image);
+    void addDateAction(QMenu *menu, const QDate &date, const QString &suffix, const QColor &swatch = QColor());
+    void showColorMatches(const QColor &color, const QPoint &globalPos);
     
     // Image download and application methods
     void downloadAndSetWallpaper();
     void downloadAndSaveWallpaper();
-    bool downloadImage();
+    void downloadImage();
+    void applyDownloadedWallpaper();
+    void saveDownloadedWallpaper();
     
     // System tray related members
-    QSystemTrayIcon *trayIcon;
+    QSystemTrayIcon *trayIcon = nullptr;
     QMenu *trayIconMenu;
     QAction *exitAction;
     QAction *dailyUpdateAction;
     QAction *lockscreenAction;
     QAction *autoStartAction;
     
-    // Timer for auto update
-    QTimer *updateTimer;
-    void resetUpdateTimer();
+    // 每日更新按壁纸发布时间计划
+    UpdateScheduler *updateScheduler;
     
     void createTrayIcon();
     bool setAutoStart(bool enable);
@@ -116,5 +166,12 @@ private:
     // New methods for UI management
     void disableUI();
     void enableUI();
+    void updateBusyState();
+
+    // 隐藏在托盘一段时间后释放可重建的内容，显示时再按需重建
+    QTimer idleTrimTimer;
+    bool idleTrimmed = false;
+    void trimIdleMemory();
+    void restoreFromIdle();
 };
 #endif // MAINWINDOW_H
@@ -3,34 +3,40 @@
 // Helper function to get application icon
 QIcon MainWindow::getApplicationIcon()
 {
-    QIcon appIcon;
+    QIcon icon;
 
     // Add our icon from resources
     QString iconPath = ":/mybingwallpaper.ico";
     if (QFile::exists(iconPath)) {
-        appIcon.addFile(iconPath);
-
-        // Load the icon once to get its pixmap
-        QPixmap originalPixmap(iconPath);
-
-        // Add various sizes for different contexts
-        if (!originalPixmap.isNull()) {
-            for (int size : {16, 24, 32, 48, 64, 128}) {
-                QPixmap scaledPixmap = originalPixmap.scaled(
-                    QSize(size, size),
-                    Qt::KeepAspectRatio,
-                    Qt::SmoothTransformation);
-                appIcon.addPixmap(scaledPixmap);
+        icon.addFile(iconPath);
+
+        // 各尺寸的平滑缩放在线程池中生成，完成后更新窗口和托盘图标
+        imageExecutor->run<QList<QImage>>(ImageExecutor::BackgroundPriority, this, [iconPath]() {
+            QList<QImage> images;
+            QImage original(iconPath);
+            if (!original.isNull()) {
+                for (int size : {16, 24, 32, 48, 64, 128}) {
+                    images.append(original.scaled(QSize(size, size), Qt::KeepAspectRatio, Qt::SmoothTransformation));
+                }
+            }
+            return images;
+        }, [this](QList<QImage> images) {
+            for (const QImage &image : std::as_const(images)) {
+                appIcon.addPixmap(QPixmap::fromImage(image));
             }
-        }
+            setWindowIcon(appIcon);
+            if (trayIcon) {
+                trayIcon->setIcon(appIcon);
+            }
+        });
     }
 
     // Fall back to a system icon if our icon is not found
-    if (appIcon.isNull()) {
-        appIcon = QApplication::style()->standardIcon(QStyle::SP_ComputerIcon);
+    if (icon.isNull()) {
+        icon = QApplication::style()->standardIcon(QStyle::SP_ComputerIcon);
     }
 
-    return appIcon;
+    return icon;
 }
 
 void MainWindow::updateCalendarMaximumDate()
@@ -39,11 +45,15 @@ void MainWindow::updateCalendarMaximumDate()
 }
 
 
-void MainWindow::resetUpdateTimer()
+bool MainWindow::nativeEvent(const QByteArray &eventType, void *message, qintptr *result)
 {
-    if (dailyUpdateAction->isChecked()) {
-        updateTimer->start(15*60*1000);
+    // 睡眠唤醒或系统时间变化后按实际时间重新计划，补上错过的更新
+    MSG *msg = static_cast<MSG *>(message);
+    if ((msg->message == WM_POWERBROADCAST && msg->wParam == PBT_APMRESUMEAUTOMATIC)
+        || msg->message == WM_TIMECHANGE) {
+        updateScheduler->catchUp();
     }
+    return QMainWindow::nativeEvent(eventType, message, result);
 }
 
 void MainWindow::closeEvent(QCloseEvent *event)
@@ -53,9 +63,76 @@ void MainWindow::closeEvent(QCloseEvent *event)
     event->ignore();
 }
 
+void MainWindow::showEvent(QShowEvent *event)
+{
+    QMainWindow::showEvent(event);
+    idleTrimTimer.stop();
+    if (idleTrimmed) {
+        restoreFromIdle();
+    }
+}
+
+void MainWindow::hideEvent(QHideEvent *event)
+{
+    QMainWindow::hideEvent(event);
+    // 稍后再释放，短时间内重新打开不必重建
+    idleTrimTimer.start();
+}
+
+void MainWindow::trimIdleMemory()
+{
+    if (isVisible()) {
+        return;
+    }
+    const QString before = processMemorySummary();
+
+    // 预览图和各尺寸图标都可以从磁盘重新生成
+    ui->label->clear();
+    ui->searchResults->clear();
+    fetcher->previewCache()->clearMemory();
+    QPixmapCache::clear();
+    if (loadingDialog) {
+        loadingDialog->deleteLater();
+        loadingDialog = nullptr;
+    }
+    if (monthOverview && !monthOverview->isVisible()) {
+        monthOverview->deleteLater();
+        monthOverview = nullptr;
+    }
+    // 只保留图标文件本身，托盘需要的尺寸由系统按需读取
+    appIcon = QIcon(":/mybingwallpaper.ico");
+    setWindowIcon(appIcon);
+    if (trayIcon) {
+        trayIcon->setIcon(appIcon);
+    }
+
+    // deleteLater的对象在下一轮事件循环中释放，之后再把空闲内存交还系统
+    QTimer::singleShot(0, this, [before]() {
+        trimProcessMemory();
+        qInfo().noquote() << "idle trim:" << before << "->" << processMemorySummary();
+    });
+    idleTrimmed = true;
+}
+
+void MainWindow::restoreFromIdle()
+{
+    idleTrimmed = false;
+    appIcon = getApplicationIcon();
+    setWindowIcon(appIcon);
+    if (trayIcon) {
+        trayIcon->setIcon(appIcon);
+    }
+    if (!currentImgUrl.isEmpty() && ui->label->pixmap().isNull()) {
+        setNetworkPic(currentImgUrl);
+    }
+}
+
 void MainWindow::exitApplication()
 {
     trayIcon->hide();
+    qInfo().noquote() << fetcher->network()->statsSummary();
+    qInfo().noquote() << fetcher->mirrorSummary();
+    qInfo().noquote() << processMemorySummary();
     QApplication::quit();
 }
 
@@ -139,7 +216,6 @@ void MainWindow::showLoadingDialog()
     updateLoadingDialogPosition();
     
     loadingDialog->show();
-    QApplication::processEvents(); // 确保对话框立即显示
 }
 
 void MainWindow::hideLoadingDialog()
@@ -177,111 +253,16 @@ void MainWindow::enableUI()
     }
 }
 
-bool MainWindow::setWindowsWallpaper(const QString &imagePath)
+void MainWindow::updateBusyState()
 {
-    if (!QFileInfo::exists(imagePath)) {
-        return false;
-    }
-
-    // Convert QString to wide string for Windows API
-    const wchar_t* wPath = reinterpret_cast<const wchar_t*>(imagePath.utf16());
-
-    // Use Windows API to set desktop wallpaper
-    // SPIF_UPDATEINIFILE | SPIF_SENDCHANGE: Update registry and notify all windows
-    BOOL result = SystemParametersInfoW(
-        SPI_SETDESKWALLPAPER,
-        0,
-        (void*)wPath,
-        SPIF_UPDATEINIFILE | SPIF_SENDCHANGE
-    );
-
-    // Only set lock screen wallpaper if enabled
-    if (lockscreenEnabled) {
-        setLockScreenWallpaper(imagePath);
-    }
-    
-    // Return true if at least the desktop wallpaper was set successfully
-    return result != 0;
-}
-
-
-bool MainWindow::setLockScreenWallpaper(const QString &imagePath)
-{
-    // Convert the relative path to absolute path if needed
-    QFileInfo fileInfo(imagePath);
-    QString absolutePath = fileInfo.absoluteFilePath();
-    
-    // Create registry key: HKEY_LOCAL_MACHINE\SOFTWARE\Microsoft\Windows\CurrentVersion\PersonalizationCSP
-    QSettings settings("HKEY_LOCAL_MACHINE\\SOFTWARE\\Microsoft\\Windows\\CurrentVersion\\PersonalizationCSP", 
-                       QSettings::NativeFormat);
-    
-    // Set the registry values
-    bool success = true;
-    
-    // Replace forward slashes with backslashes for Windows path
-    absolutePath.replace("/", "\\");
-    
-    try {
-        // Set the lock screen image path
-        settings.setValue("LockScreenImagePath", absolutePath);
-        
-        // Set the lock screen image URL (same as path for local files)
-        settings.setValue("LockScreenImageUrl", absolutePath);
-        
-        // Set the status to enabled (1)
-        settings.setValue("LockScreenImageStatus", 1);
-    }
-    catch (...) {
-        // If any error occurs, return false
-        success = false;
-
-    }
-
-    // 检测是否设置成功
-    if (settings.value("LockScreenImageStatus", 0).toInt() == 1) {
-        success = true;
+    // 获取壁纸信息或下载原图时锁定界面，预览图在后台加载不影响操作
+    if (fetcher->isBusy(WallpaperFetcher::MetadataStage) || fetcher->isBusy(WallpaperFetcher::ImageStage)) {
+        disableUI();
     } else {
-        success = false;
+        enableUI();
     }
-    
-    return success;
-}
-
-bool MainWindow::clearLockScreenWallpaper()
-{
-    qDebug() << "clearLockScreenWallpaper";
-    // Create registry key: HKEY_LOCAL_MACHINE\SOFTWARE\Microsoft\Windows\CurrentVersion\PersonalizationCSP
-    QSettings settings("HKEY_LOCAL_MACHINE\\SOFTWARE\\Microsoft\\Windows\\CurrentVersion\\PersonalizationCSP", 
-                       QSettings::NativeFormat);
-    
-    bool success = true;
-    
-    try {
-        // Remove the lock screen image path
-        settings.remove("LockScreenImagePath");
-        
-        // Remove the lock screen image URL
-        settings.remove("LockScreenImageUrl");
-        
-        // Set the status to disabled (0)
-        settings.setValue("LockScreenImageStatus", 0);
-    }
-    catch (...) {
-        // If any error occurs, return false
-        success = false;
-    }
-
-    // 检测是否设置成功
-    if (settings.value("LockScreenImageStatus", 0).toInt() == 0) {
-        success = true;
-    } else {
-        success = false;
-    }
-    
-    return success;
 }
 
-
 bool MainWindow::setAutoStart(bool enable)
 {
     QSettings settings("HKEY_CURRENT_USER\\SOFTWARE\\Microsoft\\Windows\\CurrentVersion\\Run",
@@ -0,0 +1,77 @@
+#include "metadataindex.h"
+
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStringView>
+
+MetadataIndex::ParseResult MetadataIndex::addMonth(const QString &yearMonth, const QByteArray &jsonData)
+{
+    QJsonDocument jsonDoc = QJsonDocument::fromJson(jsonData);
+    if (jsonDoc.isNull()) {
+        return InvalidJson;
+    }
+    if (!jsonDoc.isObject()) {
+        return NotAnObject;
+    }
+
+    Month month;
+    QJsonObject monthObj = jsonDoc.object();
+    for (auto it = monthObj.constBegin(); it != monthObj.constEnd(); ++it) {
+        // 键为yyyyMMdd，只收录属于该月的日期
+        const QString key = it.key();
+        if (key.size() != 8 || !key.startsWith(yearMonth)) {
+            continue;
+        }
+        int day = QStringView(key).mid(6, 2).toInt();
+        if (day < 1 || day > 31) {
+            continue;
+        }
+
+        QJsonObject dayObj = it.value().toObject();
+        month[day - 1].title = intern(dayObj["imgtitle"].toString());
+        month[day - 1].url = intern(dayObj["imgurl"].toString());
+    }
+
+    months.insert(yearMonth.toInt(), month);
+    return Parsed;
+}
+
+bool MetadataIndex::hasMonth(const QString &yearMonth) const
+{
+    return months.contains(yearMonth.toInt());
+}
+
+MetadataIndex::LookupResult MetadataIndex::lookup(const QString &date, QString *imgtitle, QString *imgurl) const
+{
+    QStringView dateView(date);
+    auto it = months.constFind(dateView.left(6).toInt());
+    if (it == months.constEnd()) {
+        return MonthMissing;
+    }
+
+    int day = dateView.mid(6, 2).toInt();
+    if (day < 1 || day > 31 || it->at(day - 1).title < 0) {
+        return DayMissing;
+    }
+
+    const DayRecord &record = it->at(day - 1);
+    *imgtitle = strings.at(record.title);
+    *imgurl = strings.at(record.url);
+    if (imgtitle->isEmpty() || imgurl->isEmpty()) {
+        return InfoMissing;
+    }
+    return Found;
+}
+
+qint32 MetadataIndex::intern(const QString &text)
+{
+    auto it = stringIds.constFind(text);
+    if (it != stringIds.constEnd()) {
+        return it.value();
+    }
+
+    qint32 id = strings.size();
+    strings.append(text);
+    stringIds.insert(text, id);
+    return id;
+}
@@ -0,0 +1,47 @@
+#ifndef METADATAINDEX_H
+#define METADATAINDEX_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QHash>
+#include <array>
+
+// 解析后的月度数据索引：每月一个按日下标的定长数组，
+// 记录中只保存标题和图片url在字符串池中的编号，相同字符串只保存一份
+// 月度json只解析一次，之后每次点击日期都是O(1)查找
+class MetadataIndex
+{
+public:
+    enum ParseResult {
+        Parsed,
+        InvalidJson,
+        NotAnObject
+    };
+
+    enum LookupResult {
+        Found,
+        MonthMissing,
+        DayMissing,
+        InfoMissing
+    };
+
+    ParseResult addMonth(const QString &yearMonth, const QByteArray &jsonData);
+    bool hasMonth(const QString &yearMonth) const;
+    LookupResult lookup(const QString &date, QString *imgtitle, QString *imgurl) const;
+
+private:
+    struct DayRecord {
+        qint32 title = -1;
+        qint32 url = -1;
+    };
+    using Month = std::array<DayRecord, 31>;
+
+    qint32 intern(const QString &text);
+
+    QHash<int, Month> months; // 键为 yyyy*100+MM
+    QStringList strings;
+    QHash<QString, qint32> stringIds;
+};
+
+#endif // METADATAINDEX_H
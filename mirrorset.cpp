@@ -0,0 +1,133 @@
+#include "mirrorset.h"
+
+#include <algorithm>
+#include <climits>
+
+namespace {
+const int maxSamples = 32;
+// 没有延迟数据时的假定值，新加入的源排在已测得较快的源之后
+const int unknownLatency = 1000;
+const int defaultHedgeDelay = 800;
+const int minHedgeDelay = 150;
+const int maxHedgeDelay = 3000;
+const int minSamplesForHedge = 5;
+const qint64 minPause = 30 * 1000;
+const qint64 maxPause = 10 * 60 * 1000;
+}
+
+MirrorSet::MirrorSet(const QStringList &baseUrls)
+{
+    clock.start();
+    setBaseUrls(baseUrls);
+}
+
+void MirrorSet::setBaseUrls(const QStringList &baseUrls)
+{
+    mirrors.clear();
+    for (QString base : baseUrls) {
+        base = base.trimmed();
+        if (base.isEmpty()) {
+            continue;
+        }
+        if (!base.endsWith('/')) {
+            base += '/';
+        }
+        Mirror mirror;
+        mirror.base = QUrl(base);
+        mirrors.append(mirror);
+    }
+}
+
+QUrl MirrorSet::url(int index, const QString &path) const
+{
+    return mirrors.at(index).base.resolved(QUrl(path));
+}
+
+bool MirrorSet::isHealthy(const Mirror &mirror) const
+{
+    return mirror.consecutiveFailures == 0 || clock.elapsed() >= mirror.retryAfter;
+}
+
+int MirrorSet::percentile(const Mirror &mirror, int percent)
+{
+    if (mirror.samples.isEmpty()) {
+        return unknownLatency;
+    }
+    QList<int> sorted = mirror.samples;
+    std::sort(sorted.begin(), sorted.end());
+    int index = int((qint64(sorted.size()) - 1) * percent / 100);
+    return sorted.at(index);
+}
+
+QList<int> MirrorSet::ranked() const
+{
+    QList<int> order;
+    QList<int> medians;
+    for (int i = 0; i < mirrors.size(); ++i) {
+        order.append(i);
+        medians.append(percentile(mirrors.at(i), 50));
+    }
+
+    // 健康的在前，再按延迟中位数，相同时保持配置顺序
+    std::stable_sort(order.begin(), order.end(), [this, &medians](int a, int b) {
+        bool healthyA = isHealthy(mirrors.at(a));
+        bool healthyB = isHealthy(mirrors.at(b));
+        if (healthyA != healthyB) {
+            return healthyA;
+        }
+        return medians.at(a) < medians.at(b);
+    });
+    return order;
+}
+
+int MirrorSet::best() const
+{
+    return mirrors.isEmpty() ? -1 : ranked().first();
+}
+
+int MirrorSet::hedgeDelay(int index) const
+{
+    const Mirror &mirror = mirrors.at(index);
+    if (mirror.samples.size() < minSamplesForHedge) {
+        return defaultHedgeDelay;
+    }
+    return qBound(minHedgeDelay, percentile(mirror, 90), maxHedgeDelay);
+}
+
+void MirrorSet::recordSuccess(int index, qint64 msecs)
+{
+    Mirror &mirror = mirrors[index];
+    int sample = int(qMin<qint64>(msecs, INT_MAX));
+    if (mirror.samples.size() < maxSamples) {
+        mirror.samples.append(sample);
+    } else {
+        mirror.samples[mirror.nextSample] = sample;
+    }
+    mirror.nextSample = (mirror.nextSample + 1) % maxSamples;
+    ++mirror.successes;
+    mirror.consecutiveFailures = 0;
+}
+
+void MirrorSet::recordFailure(int index)
+{
+    Mirror &mirror = mirrors[index];
+    ++mirror.failures;
+    ++mirror.consecutiveFailures;
+    qint64 pause = qMin(minPause << qMin(mirror.consecutiveFailures - 1, 10), maxPause);
+    mirror.retryAfter = clock.elapsed() + pause;
+}
+
+QString MirrorSet::summary() const
+{
+    QStringList lines;
+    for (const Mirror &mirror : mirrors) {
+        lines.append(QString("%1: %2 ok, %3 failed, p50 %4 ms, p90 %5 ms%6")
+                         .arg(mirror.base.host())
+                         .arg(mirror.successes)
+                         .arg(mirror.failures)
+                         .arg(mirror.samples.isEmpty() ? -1 : percentile(mirror, 50))
+                         .arg(mirror.samples.isEmpty() ? -1 : percentile(mirror, 90))
+                         .arg(isHealthy(mirror) ? "" : " (paused)"));
+    }
+    return lines.join('\n');
+}
@@ -0,0 +1,51 @@
+#ifndef MIRRORSET_H
+#define MIRRORSET_H
+
+#include <QUrl>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QElapsedTimer>
+
+// 同一份内容的多个镜像源，记录各源最近的延迟和错误
+// ranked按健康状态和延迟中位数排序；连续失败的源暂停使用一段时间(指数增长)后再尝试
+class MirrorSet
+{
+public:
+    explicit MirrorSet(const QStringList &baseUrls = QStringList());
+
+    void setBaseUrls(const QStringList &baseUrls);
+    int count() const { return int(mirrors.size()); }
+    QUrl baseUrl(int index) const { return mirrors.at(index).base; }
+    // path为相对于镜像根目录的路径，可带查询参数
+    QUrl url(int index, const QString &path) const;
+
+    QList<int> ranked() const;
+    int best() const;
+    // 超过该源延迟的90百分位仍未完成时向下一个源发出对冲请求
+    int hedgeDelay(int index) const;
+
+    void recordSuccess(int index, qint64 msecs);
+    void recordFailure(int index);
+
+    QString summary() const;
+
+private:
+    struct Mirror {
+        QUrl base;
+        QList<int> samples; // 最近的成功延迟，环形缓冲
+        int nextSample = 0;
+        int successes = 0;
+        int failures = 0;
+        int consecutiveFailures = 0;
+        qint64 retryAfter = 0;
+    };
+
+    bool isHealthy(const Mirror &mirror) const;
+    static int percentile(const Mirror &mirror, int percent);
+
+    QList<Mirror> mirrors;
+    QElapsedTimer clock;
+};
+
+#endif // MIRRORSET_H
@@ -0,0 +1,89 @@
+#include "monthcache.h"
+
+#include <QDir>
+#include <QDate>
+#include <QFile>
+#include <QSaveFile>
+#include <QSettings>
+#include <QStandardPaths>
+
+MonthCache::MonthCache(const QString &dirPath)
+{
+    cacheDir = dirPath.isEmpty() ?
+        QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/month" :
+        dirPath;
+    QDir().mkpath(cacheDir);
+    metaPath = cacheDir + "/month.ini";
+}
+
+QString MonthCache::filePath(const QString &yearMonth) const
+{
+    return cacheDir + "/" + yearMonth + ".json";
+}
+
+bool MonthCache::contains(const QString &yearMonth) const
+{
+    return QFile::exists(filePath(yearMonth));
+}
+
+bool MonthCache::isImmutable(const QString &yearMonth) const
+{
+    // 当月及以后的文件每天都会更新
+    if (yearMonth >= QDate::currentDate().toString("yyyyMM")) {
+        return false;
+    }
+
+    QSettings meta(metaPath, QSettings::IniFormat);
+    return meta.value(yearMonth + "/complete", false).toBool() && contains(yearMonth);
+}
+
+QByteArray MonthCache::load(const QString &yearMonth) const
+{
+    QFile file(filePath(yearMonth));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+    return file.readAll();
+}
+
+void MonthCache::store(const QString &yearMonth, const QByteArray &data,
+                       const QByteArray &etag, const QByteArray &lastModified)
+{
+    QSaveFile file(filePath(yearMonth));
+    if (!file.open(QIODevice::WriteOnly)) {
+        return;
+    }
+    file.write(data);
+    if (!file.commit()) {
+        return;
+    }
+
+    // 月末最后一天的数据已经存在，说明该月数据完整
+    QDate firstDay = QDate::fromString(yearMonth + "01", "yyyyMMdd");
+    QString lastDay = firstDay.addDays(firstDay.daysInMonth() - 1).toString("yyyyMMdd");
+    bool complete = data.contains("\"" + lastDay.toLatin1() + "\"");
+
+    QSettings meta(metaPath, QSettings::IniFormat);
+    meta.beginGroup(yearMonth);
+    meta.setValue("etag", QString::fromLatin1(etag));
+    meta.setValue("lastModified", QString::fromLatin1(lastModified));
+    meta.setValue("complete", complete);
+    meta.endGroup();
+}
+
+void MonthCache::addValidators(const QString &yearMonth, QNetworkRequest &request) const
+{
+    if (!contains(yearMonth)) {
+        return;
+    }
+
+    QSettings meta(metaPath, QSettings::IniFormat);
+    QString etag = meta.value(yearMonth + "/etag").toString();
+    QString lastModified = meta.value(yearMonth + "/lastModified").toString();
+    if (!etag.isEmpty()) {
+        request.setRawHeader("If-None-Match", etag.toLatin1());
+    }
+    if (!lastModified.isEmpty()) {
+        request.setRawHeader("If-Modified-Since", lastModified.toLatin1());
+    }
+}
@@ -0,0 +1,32 @@
+#ifndef MONTHCACHE_H
+#define MONTHCACHE_H
+
+#include <QString>
+#include <QByteArray>
+#include <QtNetwork/QNetworkRequest>
+
+// 月度json文件的本地磁盘缓存，以yyyyMM为键
+// 已结束且数据完整的月份不会再变化，直接使用缓存；
+// 当月文件带上ETag/Last-Modified做条件请求，304时复用缓存
+class MonthCache
+{
+public:
+    explicit MonthCache(const QString &dirPath = QString());
+
+    bool contains(const QString &yearMonth) const;
+    bool isImmutable(const QString &yearMonth) const;
+    QByteArray load(const QString &yearMonth) const;
+    void store(const QString &yearMonth, const QByteArray &data,
+               const QByteArray &etag, const QByteArray &lastModified);
+
+    // 为当月文件的请求添加条件请求头
+    void addValidators(const QString &yearMonth, QNetworkRequest &request) const;
+
+private:
+    QString filePath(const QString &yearMonth) const;
+
+    QString cacheDir;
+    QString metaPath;
+};
+
+#endif // MONTHCACHE_H
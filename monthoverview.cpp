@@ -0,0 +1,353 @@
+#include "monthoverview.h"
+#include "wallpaperfetcher.h"
+#include "imageexecutor.h"
+#include "previewdecoder.h"
+
+#include <QPainter>
+#include <QPaintEvent>
+#include <QScrollBar>
+#include <QMouseEvent>
+#include <QHelpEvent>
+#include <QToolTip>
+
+namespace {
+
+const int CellWidth = 128;
+const int CellHeight = 72;
+const int Gap = 4;
+const int Gutter = 64;
+const int RowHeight = CellHeight + Gap;
+
+}
+
+MonthOverview::MonthOverview(WallpaperFetcher *fetcher, ImageExecutor *executor, QWidget *parent)
+    : QAbstractScrollArea(parent)
+    , fetcher(fetcher)
+    , executor(executor)
+    , atlas(QSize(CellWidth, CellHeight))
+{
+    const QDate firstDate = ArchiveIndex::firstDate();
+    firstMonday = firstDate.addDays(1 - firstDate.dayOfWeek());
+
+    setWindowTitle(tr("全部壁纸"));
+    setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOn);
+    viewport()->setAttribute(Qt::WA_OpaquePaintEvent);
+    resize(Gutter + 7 * (CellWidth + Gap) + verticalScrollBar()->sizeHint().width() + 2 * frameWidth(), 8 * RowHeight);
+
+    pumpTimer.setSingleShot(true);
+    pumpTimer.setInterval(0);
+    connect(&pumpTimer, &QTimer::timeout, this, &MonthOverview::pump);
+    connect(verticalScrollBar(), &QScrollBar::valueChanged, this, &MonthOverview::abortInvisible);
+}
+
+int MonthOverview::rowCount() const
+{
+    return int(firstMonday.daysTo(QDate::currentDate()) / 7) + 1;
+}
+
+int MonthOverview::rowOf(const QDate &date) const
+{
+    return int(firstMonday.daysTo(date) / 7);
+}
+
+QRect MonthOverview::cellRect(const QDate &date) const
+{
+    return QRect(Gutter + (date.dayOfWeek() - 1) * (CellWidth + Gap),
+                 rowOf(date) * RowHeight - verticalScrollBar()->value(), CellWidth, CellHeight);
+}
+
+QDate MonthOverview::dateAt(const QPoint &pos) const
+{
+    const int x = pos.x() - Gutter;
+    const int y = pos.y() + verticalScrollBar()->value();
+    if (x < 0 || y < 0 || x % (CellWidth + Gap) >= CellWidth || y % RowHeight >= CellHeight) {
+        return QDate();
+    }
+    const int column = x / (CellWidth + Gap);
+    QDate date = firstMonday.addDays(qint64(y / RowHeight) * 7 + column);
+    if (column >= 7 || date < ArchiveIndex::firstDate() || date > QDate::currentDate()) {
+        return QDate();
+    }
+    return date;
+}
+
+void MonthOverview::updateScrollRange()
+{
+    QScrollBar *bar = verticalScrollBar();
+    bar->setRange(0, qMax(0, rowCount() * RowHeight - Gap - viewport()->height()));
+    bar->setPageStep(viewport()->height());
+    bar->setSingleStep(RowHeight / 2);
+}
+
+void MonthOverview::setSelectedDate(const QDate &date)
+{
+    selected = date;
+    updateScrollRange();
+    // 选中行放在视口的上三分之一处
+    QScrollBar *bar = verticalScrollBar();
+    const int top = rowOf(date) * RowHeight;
+    if (top < bar->value() || top + CellHeight > bar->value() + viewport()->height()) {
+        bar->setValue(top - viewport()->height() / 3);
+    }
+    viewport()->update();
+}
+
+void MonthOverview::resizeEvent(QResizeEvent *event)
+{
+    QAbstractScrollArea::resizeEvent(event);
+    updateScrollRange();
+}
+
+void MonthOverview::paintEvent(QPaintEvent *event)
+{
+    QPainter painter(viewport());
+    painter.fillRect(event->rect(), palette().color(QPalette::Window).darker(160));
+
+    const QDate today = QDate::currentDate();
+    int firstRow, lastRow;
+    visibleRows(&firstRow, &lastRow);
+
+    QFont dayFont = font();
+    if (dayFont.pointSizeF() > 0) {
+        dayFont.setPointSizeF(dayFont.pointSizeF() * 0.85);
+    }
+    for (int row = firstRow; row <= lastRow; ++row) {
+        for (int column = 0; column < 7; ++column) {
+            const QDate date = firstMonday.addDays(qint64(row) * 7 + column);
+            if (date < ArchiveIndex::firstDate() || date > today) {
+                continue;
+            }
+            const QRect rect = cellRect(date);
+
+            // 每月1日所在行的左侧标出年月
+            if (date.day() == 1) {
+                painter.setFont(font());
+                painter.setPen(palette().color(QPalette::BrightText));
+                painter.drawText(QRect(0, rect.top(), Gutter - 2 * Gap, CellHeight), Qt::AlignRight | Qt::AlignVCenter,
+                                 date.toString(date.month() == 1 ? "yyyy\nM月" : "M月"));
+            }
+            if (!rect.intersects(event->rect())) {
+                continue;
+            }
+
+            // 没有缩略图时画占位，相邻月份的底色深浅交替
+            if (!atlas.draw(&painter, rect, date.toJulianDay())) {
+                painter.fillRect(rect, date.month() % 2 ? QColor(58, 58, 58) : QColor(72, 72, 72));
+            }
+            painter.setFont(dayFont);
+            painter.setPen(QColor(0, 0, 0, 160));
+            painter.drawText(rect.adjusted(5, 3, 0, 0), Qt::AlignLeft | Qt::AlignTop, QString::number(date.day()));
+            painter.setPen(Qt::white);
+            painter.drawText(rect.adjusted(4, 2, 0, 0), Qt::AlignLeft | Qt::AlignTop, QString::number(date.day()));
+            if (date == selected) {
+                painter.setPen(QPen(palette().color(QPalette::Highlight), 3));
+                painter.drawRect(rect.adjusted(1, 1, -2, -2));
+            }
+        }
+    }
+    updateWanted();
+}
+
+void MonthOverview::visibleRows(int *firstRow, int *lastRow) const
+{
+    const int scroll = verticalScrollBar()->value();
+    *firstRow = qMax(0, scroll / RowHeight);
+    *lastRow = qMin(rowCount() - 1, (scroll + viewport()->height()) / RowHeight);
+}
+
+void MonthOverview::updateWanted()
+{
+    // 按整个视口收集，与本次绘制的区域无关(解码完成后只重绘一个格子)
+    const QDate today = QDate::currentDate();
+    int firstRow, lastRow;
+    visibleRows(&firstRow, &lastRow);
+    wanted.clear();
+    for (int row = firstRow; row <= lastRow; ++row) {
+        for (int column = 0; column < 7; ++column) {
+            const QDate date = firstMonday.addDays(qint64(row) * 7 + column);
+            const qint64 key = date.toJulianDay();
+            if (date >= ArchiveIndex::firstDate() && date <= today && !atlas.contains(key) && !missing.contains(key)) {
+                wanted.append(date);
+            }
+        }
+    }
+    schedulePump();
+}
+
+bool MonthOverview::viewportEvent(QEvent *event)
+{
+    if (event->type() == QEvent::ToolTip) {
+        auto *helpEvent = static_cast<QHelpEvent *>(event);
+        const QDate date = dateAt(helpEvent->pos());
+        QString imgtitle, imgurl;
+        if (date.isValid() && fetcher->cachedMetadata(date.toString("yyyyMMdd"), &imgtitle, &imgurl)) {
+            QToolTip::showText(helpEvent->globalPos(), date.toString("yyyy-MM-dd") + "\n" + imgtitle, viewport());
+        } else {
+            QToolTip::hideText();
+        }
+        return true;
+    }
+    return QAbstractScrollArea::viewportEvent(event);
+}
+
+void MonthOverview::mousePressEvent(QMouseEvent *event)
+{
+    const QDate date = dateAt(event->position().toPoint());
+    if (event->button() != Qt::LeftButton || !date.isValid()) {
+        QAbstractScrollArea::mousePressEvent(event);
+        return;
+    }
+    selected = date;
+    viewport()->update();
+    emit dateActivated(date);
+}
+
+void MonthOverview::hideEvent(QHideEvent *event)
+{
+    QAbstractScrollArea::hideEvent(event);
+    release();
+}
+
+void MonthOverview::release()
+{
+    // 不显示时不占用缩略图内存和网络
+    pumpTimer.stop();
+    wanted.clear();
+    const QList<QPointer<QNetworkReply>> replies = downloads.values();
+    downloads.clear();
+    for (const QPointer<QNetworkReply> &reply : replies) {
+        if (reply) {
+            reply->disconnect(this);
+            reply->abort();
+        }
+    }
+    months.clear();
+    missing.clear();
+    atlas.clear();
+}
+
+void MonthOverview::abortInvisible()
+{
+    // 滚出视口的日期不再下载，之后滚回来时重新请求
+    const QRect visible = viewport()->rect();
+    for (auto it = downloads.begin(); it != downloads.end(); ) {
+        if (cellRect(QDate::fromJulianDay(it.key())).intersects(visible)) {
+            ++it;
+            continue;
+        }
+        QPointer<QNetworkReply> reply = it.value();
+        it = downloads.erase(it);
+        if (reply) {
+            months.remove(reply->property("overviewMonth").toString());
+            reply->disconnect(this);
+            reply->abort();
+        }
+    }
+}
+
+void MonthOverview::schedulePump()
+{
+    if (!wanted.isEmpty() && !pumpTimer.isActive()) {
+        pumpTimer.start();
+    }
+}
+
+void MonthOverview::pump()
+{
+    for (const QDate &date : std::as_const(wanted)) {
+        if (decoding.size() >= maxDecoding) {
+            break;
+        }
+        const qint64 key = date.toJulianDay();
+        if (!decoding.contains(key) && !downloads.contains(key) && !missing.contains(key) && !atlas.contains(key)) {
+            load(date);
+        }
+    }
+}
+
+void MonthOverview::load(const QDate &date)
+{
+    const qint64 key = date.toJulianDay();
+    QString imgtitle, imgurl;
+    if (!fetcher->cachedMetadata(date.toString("yyyyMMdd"), &imgtitle, &imgurl)) {
+        // 同一个月的日期共用一次月度json请求
+        const QString yearMonth = date.toString("yyyyMM");
+        if (months.value(yearMonth)) {
+            missing.insert(key);
+            return;
+        }
+        if (months.contains(yearMonth) || downloads.size() >= maxDownloads) {
+            return;
+        }
+        QNetworkReply *reply = fetcher->warmMonth(yearMonth);
+        if (!reply) {
+            missing.insert(key);
+            return;
+        }
+        months.insert(yearMonth, false);
+        track(date, reply, yearMonth);
+        return;
+    }
+
+    // 优先用已存储的原图，其次是缓存的预览图，都没有时下载预览图
+    const QString storedPath = fetcher->imageStore()->find(imgurl);
+    if (!storedPath.isEmpty()) {
+        decode(date, storedPath, QByteArray());
+        return;
+    }
+    const QByteArray data = fetcher->previewCache()->data(imgurl);
+    if (!data.isEmpty()) {
+        decode(date, QString(), data);
+        return;
+    }
+    if (downloads.size() >= maxDownloads) {
+        return;
+    }
+    QNetworkReply *reply = fetcher->warmPreview(imgurl);
+    if (!reply) {
+        missing.insert(key);
+        return;
+    }
+    track(date, reply, QString());
+}
+
+void MonthOverview::track(const QDate &date, QNetworkReply *reply, const QString &yearMonth)
+{
+    const qint64 key = date.toJulianDay();
+    reply->setProperty("overviewMonth", yearMonth);
+    downloads.insert(key, reply);
+    connect(reply, &QNetworkReply::finished, this, [this, key, reply, yearMonth]() {
+        downloads.remove(key);
+        if (!yearMonth.isEmpty()) {
+            months.insert(yearMonth, true);
+        } else if (reply->error() != QNetworkReply::NoError) {
+            missing.insert(key);
+        }
+        viewport()->update();
+    });
+}
+
+void MonthOverview::decode(const QDate &date, const QString &filePath, const QByteArray &data)
+{
+    const qint64 key = date.toJulianDay();
+    decoding.insert(key);
+    const QSize size = atlas.cellSize();
+    executor->run<QImage>(ImageExecutor::PrefetchPriority, this, [filePath, data, size]() {
+        return filePath.isEmpty() ? PreviewDecoder::decodeScaled(data, size)
+                                  : PreviewDecoder::decodeScaledFile(filePath, size);
+    }, [this, date, key](QImage image) {
+        decoding.remove(key);
+        // 解码期间窗口已隐藏时丢弃
+        if (!isVisible()) {
+            return;
+        }
+        if (image.isNull()) {
+            missing.insert(key);
+        } else {
+            atlas.insert(key, image);
+        }
+        viewport()->update(cellRect(date));
+        updateWanted();
+    });
+}
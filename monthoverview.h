@@ -0,0 +1,72 @@
+#ifndef MONTHOVERVIEW_H
+#define MONTHOVERVIEW_H
+
+#include <QAbstractScrollArea>
+#include <QDate>
+#include <QList>
+#include <QHash>
+#include <QSet>
+#include <QPointer>
+#include <QTimer>
+#include <QtNetwork/QNetworkReply>
+#include "thumbnailatlas.h"
+
+class WallpaperFetcher;
+class ImageExecutor;
+
+// 所有日期的缩略图总览，每行一周，从2010年连续排到今天，左侧标出月份
+// 只绘制和加载可见的格子：缩略图按需解码后放入共用的ThumbnailAtlas，滚动时只是从中复制，
+// 滚过的月份由图集按最近使用淘汰，内存不随浏览的范围增长；隐藏时全部释放
+class MonthOverview : public QAbstractScrollArea
+{
+    Q_OBJECT
+
+public:
+    explicit MonthOverview(WallpaperFetcher *fetcher, ImageExecutor *executor, QWidget *parent = nullptr);
+
+    // 高亮该日期并滚动到可见处
+    void setSelectedDate(const QDate &date);
+    qint64 memoryBytes() const { return atlas.memoryBytes(); }
+
+signals:
+    void dateActivated(const QDate &date);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+    bool viewportEvent(QEvent *event) override;
+
+private:
+    void updateScrollRange();
+    int rowCount() const;
+    int rowOf(const QDate &date) const;
+    QRect cellRect(const QDate &date) const;
+    QDate dateAt(const QPoint &pos) const;
+    void visibleRows(int *firstRow, int *lastRow) const;
+    void updateWanted();
+    void schedulePump();
+    void pump();
+    void load(const QDate &date);
+    void decode(const QDate &date, const QString &filePath, const QByteArray &data);
+    void track(const QDate &date, QNetworkReply *reply, const QString &yearMonth);
+    void abortInvisible();
+    void release();
+
+    WallpaperFetcher *fetcher;
+    ImageExecutor *executor;
+    ThumbnailAtlas atlas;
+    QDate firstMonday;
+    QDate selected;
+    QList<QDate> wanted;                             // 可见但还没有缩略图，从上到下
+    QSet<qint64> decoding;
+    QHash<qint64, QPointer<QNetworkReply>> downloads; // 月度json或预览图
+    QHash<QString, bool> months;                     // 已请求的月份，true为已完成
+    QSet<qint64> missing;                            // 没有数据，本次显示期间不再请求
+    QTimer pumpTimer;
+    int maxDecoding = 4;
+    int maxDownloads = 4;
+};
+
+#endif // MONTHOVERVIEW_H
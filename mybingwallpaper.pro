@@ -9,12 +9,76 @@ CONFIG += c++17
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+    archiveindex.cpp \
+    archivesync.cpp \
+    colorindex.cpp \
+    connectivitywatcher.cpp \
+    cpufeatures.cpp \
+    fileutil.cpp \
+    hedgedrequest.cpp \
+    headless.cpp \
+    imageexecutor.cpp \
+    imageindexer.cpp \
+    imagestore.cpp \
     main.cpp \
     mainwindow.cpp \
-    mainwindow_func.cpp
+    mainwindow_func.cpp \
+    metadataindex.cpp \
+    mirrorset.cpp \
+    monthcache.cpp \
+    monthoverview.cpp \
+    networkmanager.cpp \
+    perceptualindex.cpp \
+    platform.cpp \
+    prefetcher.cpp \
+    previewdecoder.cpp \
+    previewcache.cpp \
+    rangeddownload.cpp \
+    resampler.cpp \
+    thumbnailatlas.cpp \
+    titleindex.cpp \
+    updatescheduler.cpp \
+    wallpaperfetcher.cpp \
+    wallpaperrenderer.cpp
 
 HEADERS += \
-    mainwindow.h
+    archiveindex.h \
+    archivesync.h \
+    colorindex.h \
+    connectivitywatcher.h \
+    cpufeatures.h \
+    fileutil.h \
+    hedgedrequest.h \
+    headless.h \
+    imageexecutor.h \
+    imageindexer.h \
+    imagestore.h \
+    mainwindow.h \
+    metadataindex.h \
+    mirrorset.h \
+    monthcache.h \
+    monthoverview.h \
+    networkmanager.h \
+    perceptualindex.h \
+    platform.h \
+    prefetcher.h \
+    previewdecoder.h \
+    previewcache.h \
+    rangeddownload.h \
+    resampler.h \
+    thumbnailatlas.h \
+    titleindex.h \
+    updatescheduler.h \
+    wallpaperfetcher.h \
+    wallpaperrenderer.h
+
+# 性能测试: qmake CONFIG+=bench，运行 mybingwallpaper --bench [名称...]
+bench {
+    DEFINES += MYBING_BENCH
+    CONFIG += console
+    SOURCES += benchmark.cpp benchserver.cpp
+    HEADERS += benchmark.h benchserver.h
+}
 
 FORMS += \
     mainwindow.ui
@@ -27,5 +91,8 @@ else: unix:!android: target.path = /opt/$${TARGET}/bin
 RESOURCES += \
     resource.qrc
 
+# IDesktopWallpaper逐个显示器设置壁纸，GetProcessMemoryInfo读取内存占用
+win32: LIBS += -lole32 -lpsapi
+
 RC_ICONS = mybingwallpaper.ico
 RC_FILE = main.rc
\ No newline at end of file
@@ -0,0 +1,79 @@
+#include "networkmanager.h"
+
+#include <QElapsedTimer>
+#include <QSet>
+#include <memory>
+
+NetworkManager::NetworkManager(QObject *parent)
+    : QNetworkAccessManager(parent)
+{
+}
+
+void NetworkManager::warmUp(const QList<QUrl> &urls)
+{
+    QSet<QString> hosts;
+    for (const QUrl &url : urls) {
+        if (url.scheme() != "https" || url.host().isEmpty() || hosts.contains(url.host())) {
+            continue;
+        }
+        hosts.insert(url.host());
+        connectToHostEncrypted(url.host(), quint16(url.port(443)));
+        ++counters.warmed;
+    }
+}
+
+QNetworkReply *NetworkManager::createRequest(Operation op, const QNetworkRequest &request, QIODevice *outgoingData)
+{
+    QNetworkRequest shared(request);
+    shared.setAttribute(QNetworkRequest::Http2AllowedAttribute, true);
+    QNetworkReply *reply = QNetworkAccessManager::createRequest(op, shared, outgoingData);
+
+    // socketStartedConnecting只在需要新建连接时发出，复用已有连接的请求不会收到
+    struct Trace {
+        QElapsedTimer connectTimer;
+        bool newConnection = false;
+    };
+    auto trace = std::make_shared<Trace>();
+    connect(reply, &QNetworkReply::socketStartedConnecting, this, [this, trace]() {
+        if (!trace->newConnection) {
+            trace->newConnection = true;
+            ++counters.newConnections;
+        }
+        trace->connectTimer.start();
+    });
+    connect(reply, &QNetworkReply::encrypted, this, [this, trace]() {
+        if (trace->connectTimer.isValid()) {
+            ++counters.handshakes;
+            counters.handshakeMsecs += trace->connectTimer.elapsed();
+            trace->connectTimer.invalidate();
+        }
+    });
+    connect(reply, &QNetworkReply::finished, this, [this, reply]() {
+        // 只统计收到响应的请求，被取消的不算
+        if (reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).isValid()) {
+            ++counters.requests;
+        }
+    });
+    return reply;
+}
+
+qint64 NetworkManager::savedMsecs() const
+{
+    if (counters.handshakes == 0) {
+        return 0;
+    }
+    int reused = qMax(0, counters.requests - counters.newConnections);
+    return qint64(reused) * counters.handshakeMsecs / counters.handshakes;
+}
+
+QString NetworkManager::statsSummary() const
+{
+    return QString("network: %1 requests, %2 new connections, %3 TLS handshakes (avg %4 ms), "
+                   "%5 warmed, ~%6 ms saved by reuse")
+        .arg(counters.requests)
+        .arg(counters.newConnections)
+        .arg(counters.handshakes)
+        .arg(counters.handshakes ? counters.handshakeMsecs / counters.handshakes : 0)
+        .arg(counters.warmed)
+        .arg(savedMsecs());
+}
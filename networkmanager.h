@@ -0,0 +1,44 @@
+#ifndef NETWORKMANAGER_H
+#define NETWORKMANAGER_H
+
+#include <QUrl>
+#include <QList>
+#include <QString>
+#include <QtNetwork/QNetworkAccessManager>
+#include <QtNetwork/QNetworkReply>
+
+// 整个进程共用的网络管理器，生命周期与程序相同
+// 出错时只取消失败的请求，连接池、TLS会话和DNS缓存一直保留；允许HTTP/2，同一主机的请求复用连接
+// 统计新建连接和TLS握手次数，估算复用连接节省的时间
+class NetworkManager : public QNetworkAccessManager
+{
+    Q_OBJECT
+
+public:
+    struct Stats {
+        int requests = 0;       // 已完成的请求
+        int newConnections = 0; // 需要新建连接的请求
+        int handshakes = 0;     // TLS握手次数
+        qint64 handshakeMsecs = 0;
+        int warmed = 0;         // 预先建立的连接
+    };
+
+    explicit NetworkManager(QObject *parent = nullptr);
+
+    // 预先建立到这些主机的加密连接，首个请求不再等待握手
+    void warmUp(const QList<QUrl> &urls);
+
+    const Stats &stats() const { return counters; }
+    // 复用连接的请求数乘以平均握手耗时
+    qint64 savedMsecs() const;
+    QString statsSummary() const;
+
+protected:
+    QNetworkReply *createRequest(Operation op, const QNetworkRequest &request,
+                                 QIODevice *outgoingData = nullptr) override;
+
+private:
+    Stats counters;
+};
+
+#endif // NETWORKMANAGER_H
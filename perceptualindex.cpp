@@ -0,0 +1,197 @@
+#include "perceptualindex.h"
+#include "resampler.h"
+#include "cpufeatures.h"
+
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <algorithm>
+
+namespace {
+
+const quint32 indexMagic = 0x4850424d; // "MBPH"
+const quint32 indexVersion = 1;
+
+void distancesScalar(const quint64 *hashes, qsizetype count, quint64 query, quint8 *out)
+{
+    for (qsizetype i = 0; i < count; ++i) {
+        out[i] = quint8(qPopulationCount(hashes[i] ^ query));
+    }
+}
+
+#if defined(Q_PROCESSOR_X86)
+
+CPU_TARGET_AVX2 void distancesAvx2(const quint64 *hashes, qsizetype count, quint64 query, quint8 *out)
+{
+    // 每次比较4个哈希：按半字节查表得到每字节的位数，再用sad把8个字节加成一个64位和
+    const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i lowNibble = _mm256_set1_epi8(0x0f);
+    const __m256i q = _mm256_set1_epi64x(qint64(query));
+    qsizetype i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256i x = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(hashes + i)), q);
+        __m256i lo = _mm256_shuffle_epi8(lookup, _mm256_and_si256(x, lowNibble));
+        __m256i hi = _mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(x, 4), lowNibble));
+        __m256i sums = _mm256_sad_epu8(_mm256_add_epi8(lo, hi), _mm256_setzero_si256());
+        // 4个和分别在每个64位的最低字节
+        quint64 lanes[4];
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(lanes), sums);
+        out[i] = quint8(lanes[0]);
+        out[i + 1] = quint8(lanes[1]);
+        out[i + 2] = quint8(lanes[2]);
+        out[i + 3] = quint8(lanes[3]);
+    }
+    distancesScalar(hashes + i, count - i, query, out + i);
+}
+
+#endif
+
+}
+
+PerceptualIndex::PerceptualIndex(const QString &filePath)
+    : filePath(filePath)
+{
+    if (this->filePath.isEmpty()) {
+        QString dataDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+        QDir().mkpath(dataDir);
+        this->filePath = dataDir + "/phash.idx";
+    }
+    load();
+}
+
+void PerceptualIndex::load()
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    Header header;
+    if (file.read(reinterpret_cast<char *>(&header), sizeof(Header)) != qint64(sizeof(Header))
+        || header.magic != indexMagic || header.version != indexVersion
+        || file.size() != qint64(sizeof(Header)) + qint64(header.count) * (sizeof(quint64) + sizeof(quint32))) {
+        return;
+    }
+
+    hashes.resize(header.count);
+    days.resize(header.count);
+    const qint64 hashBytes = qint64(header.count) * sizeof(quint64);
+    const qint64 dayBytes = qint64(header.count) * sizeof(quint32);
+    if (file.read(reinterpret_cast<char *>(hashes.data()), hashBytes) != hashBytes
+        || file.read(reinterpret_cast<char *>(days.data()), dayBytes) != dayBytes) {
+        hashes.clear();
+        days.clear();
+        return;
+    }
+    for (qsizetype i = 0; i < days.size(); ++i) {
+        positions.insert(days.at(i), i);
+    }
+}
+
+bool PerceptualIndex::commit()
+{
+    if (!dirty) {
+        return true;
+    }
+
+    Header header = {indexMagic, indexVersion, quint32(hashes.size()), 0};
+    const qint64 hashBytes = hashes.size() * qint64(sizeof(quint64));
+    const qint64 dayBytes = days.size() * qint64(sizeof(quint32));
+    QSaveFile file(filePath);
+    bool written = file.open(QIODevice::WriteOnly)
+        && file.write(reinterpret_cast<const char *>(&header), sizeof(Header)) == qint64(sizeof(Header))
+        && file.write(reinterpret_cast<const char *>(hashes.constData()), hashBytes) == hashBytes
+        && file.write(reinterpret_cast<const char *>(days.constData()), dayBytes) == dayBytes
+        && file.commit();
+    if (written) {
+        dirty = false;
+    }
+    return written;
+}
+
+quint64 PerceptualIndex::imageHash(const QImage &image)
+{
+    QImage small = Resampler::scaled(image, QSize(9, 8), Resampler::Bicubic);
+    if (small.isNull()) {
+        return 0;
+    }
+
+    quint64 hash = 0;
+    for (int y = 0; y < 8; ++y) {
+        const QRgb *line = reinterpret_cast<const QRgb *>(small.constScanLine(y));
+        for (int x = 0; x < 8; ++x) {
+            if (qGray(line[x]) > qGray(line[x + 1])) {
+                hash |= quint64(1) << (y * 8 + x);
+            }
+        }
+    }
+    return hash;
+}
+
+void PerceptualIndex::hammingDistances(const quint64 *hashes, qsizetype count, quint64 query, quint8 *out)
+{
+#if defined(Q_PROCESSOR_X86)
+    if (cpuHasAvx2()) {
+        distancesAvx2(hashes, count, query, out);
+        return;
+    }
+#endif
+    distancesScalar(hashes, count, query, out);
+}
+
+bool PerceptualIndex::hash(const QDate &date, quint64 *value) const
+{
+    auto it = positions.constFind(date.toJulianDay());
+    if (it == positions.constEnd()) {
+        return false;
+    }
+    *value = hashes.at(it.value());
+    return true;
+}
+
+void PerceptualIndex::insert(const QDate &date, quint64 hash)
+{
+    const qint64 day = date.toJulianDay();
+    auto it = positions.constFind(day);
+    if (it != positions.constEnd()) {
+        if (hashes.at(it.value()) == hash) {
+            return;
+        }
+        hashes[it.value()] = hash;
+    } else {
+        positions.insert(day, hashes.size());
+        hashes.append(hash);
+        days.append(quint32(day));
+    }
+    dirty = true;
+}
+
+QList<PerceptualIndex::Match> PerceptualIndex::similar(quint64 hash, int maxDistance, int limit,
+                                                       const QDate &exclude) const
+{
+    QList<quint8> distances(hashes.size());
+    hammingDistances(hashes.constData(), hashes.size(), hash, distances.data());
+
+    const quint32 excludeDay = exclude.isValid() ? quint32(exclude.toJulianDay()) : 0;
+    QList<Match> matches;
+    for (qsizetype i = 0; i < distances.size(); ++i) {
+        if (distances.at(i) <= maxDistance && days.at(i) != excludeDay) {
+            matches.append(Match{QDate::fromJulianDay(days.at(i)), distances.at(i)});
+        }
+    }
+    std::sort(matches.begin(), matches.end(), [](const Match &a, const Match &b) {
+        return a.distance != b.distance ? a.distance < b.distance : a.date > b.date;
+    });
+    if (limit >= 0 && matches.size() > limit) {
+        matches.resize(limit);
+    }
+    return matches;
+}
+
+QDate PerceptualIndex::findDuplicate(quint64 hash, const QDate &exclude) const
+{
+    QList<Match> matches = similar(hash, DuplicateDistance, 1, exclude);
+    return matches.isEmpty() ? QDate() : matches.first().date;
+}
@@ -0,0 +1,62 @@
+#ifndef PERCEPTUALINDEX_H
+#define PERCEPTUALINDEX_H
+
+#include <QString>
+#include <QDate>
+#include <QImage>
+#include <QList>
+#include <QHash>
+
+// 存档中每张图片的感知哈希(dHash，64位)，用于查找相似图片和重复图片
+// 文件结构: Header | quint64 hash[count] | quint32 julianDay[count]，启动时整体读入内存；
+// 哈希连续存放，查询时对整个存档做异或+popcount，按CPU使用AVX2
+class PerceptualIndex
+{
+public:
+    struct Match {
+        QDate date;
+        int distance;  // 不同的位数，0-64
+    };
+
+    // 不超过此距离视为同一张图片(重新发布、不同分辨率或重新压缩)
+    static const int DuplicateDistance = 4;
+    static const int SimilarDistance = 14;
+
+    explicit PerceptualIndex(const QString &filePath = QString());
+
+    // 缩小为9x8灰度图，比较每行相邻像素的明暗
+    static quint64 imageHash(const QImage &image);
+    // out[i]为hashes[i]与query的汉明距离
+    static void hammingDistances(const quint64 *hashes, qsizetype count, quint64 query, quint8 *out);
+
+    int count() const { return int(hashes.size()); }
+    bool contains(const QDate &date) const { return positions.contains(date.toJulianDay()); }
+    bool hash(const QDate &date, quint64 *value) const;
+    void insert(const QDate &date, quint64 hash);
+
+    // 按距离、日期排序，不包括exclude
+    QList<Match> similar(quint64 hash, int maxDistance, int limit, const QDate &exclude = QDate()) const;
+    // 距离不超过DuplicateDistance的最近一张，没有时返回无效日期
+    QDate findDuplicate(quint64 hash, const QDate &exclude = QDate()) const;
+
+    bool hasPending() const { return dirty; }
+    bool commit();
+
+private:
+    struct Header {
+        quint32 magic;
+        quint32 version;
+        quint32 count;
+        quint32 reserved;
+    };
+
+    void load();
+
+    QString filePath;
+    QList<quint64> hashes;
+    QList<quint32> days;             // 儒略日，与hashes一一对应
+    QHash<qint64, qsizetype> positions;
+    bool dirty = false;
+};
+
+#endif // PERCEPTUALINDEX_H
@@ -0,0 +1,250 @@
+#include "platform.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QSettings>
+#include <QDebug>
+#include <cstdio>
+#include <malloc.h>
+#include <Windows.h>
+#include <psapi.h>
+#include <shobjidl.h>
+
+namespace {
+
+// 命令行模式的线程没有初始化COM，在这里初始化；界面线程已初始化时沿用
+class ComScope
+{
+public:
+    ComScope() : result(CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED)) {}
+    ~ComScope()
+    {
+        if (SUCCEEDED(result)) {
+            CoUninitialize();
+        }
+    }
+
+private:
+    HRESULT result;
+};
+
+IDesktopWallpaper *createDesktopWallpaper()
+{
+    IDesktopWallpaper *wallpaper = nullptr;
+    if (FAILED(CoCreateInstance(__uuidof(DesktopWallpaper), nullptr, CLSCTX_ALL, IID_PPV_ARGS(&wallpaper)))) {
+        return nullptr;
+    }
+    return wallpaper;
+}
+
+}
+
+bool setDesktopWallpaper(const QString &imagePath)
+{
+    if (!QFileInfo::exists(imagePath)) {
+        return false;
+    }
+
+    // Convert QString to wide string for Windows API
+    const wchar_t* wPath = reinterpret_cast<const wchar_t*>(imagePath.utf16());
+
+    // Use Windows API to set desktop wallpaper
+    // SPIF_UPDATEINIFILE | SPIF_SENDCHANGE: Update registry and notify all windows
+    BOOL result = SystemParametersInfoW(
+        SPI_SETDESKWALLPAPER,
+        0,
+        (void*)wPath,
+        SPIF_UPDATEINIFILE | SPIF_SENDCHANGE
+    );
+
+    return result != 0;
+}
+
+QList<DesktopMonitor> desktopMonitors()
+{
+    QList<DesktopMonitor> monitors;
+    ComScope com;
+
+    // 按物理像素获取显示器区域，不受本进程DPI感知方式影响
+    DPI_AWARENESS_CONTEXT oldContext = SetThreadDpiAwarenessContext(DPI_AWARENESS_CONTEXT_PER_MONITOR_AWARE_V2);
+
+    IDesktopWallpaper *wallpaper = createDesktopWallpaper();
+    UINT count = 0;
+    if (wallpaper && SUCCEEDED(wallpaper->GetMonitorDevicePathCount(&count))) {
+        for (UINT i = 0; i < count; ++i) {
+            LPWSTR id = nullptr;
+            if (FAILED(wallpaper->GetMonitorDevicePathAt(i, &id))) {
+                continue;
+            }
+            // 未连接的显示器没有区域
+            RECT rect;
+            if (SUCCEEDED(wallpaper->GetMonitorRECT(id, &rect)) && rect.right > rect.left && rect.bottom > rect.top) {
+                monitors.append({QString::fromWCharArray(id),
+                                 QRect(rect.left, rect.top, rect.right - rect.left, rect.bottom - rect.top)});
+            }
+            CoTaskMemFree(id);
+        }
+    }
+    if (wallpaper) {
+        wallpaper->Release();
+    }
+
+    if (oldContext) {
+        SetThreadDpiAwarenessContext(oldContext);
+    }
+    return monitors;
+}
+
+bool setMonitorWallpapers(const QList<DesktopMonitor> &monitors, const QStringList &imagePaths)
+{
+    if (monitors.isEmpty() || monitors.size() != imagePaths.size()) {
+        return false;
+    }
+
+    ComScope com;
+    IDesktopWallpaper *wallpaper = createDesktopWallpaper();
+    if (!wallpaper) {
+        return false;
+    }
+
+    // 图片已按显示器宽高比裁剪，填充方式下不会再被裁剪或留边
+    bool ok = SUCCEEDED(wallpaper->SetPosition(DWPOS_FILL));
+    for (int i = 0; i < monitors.size() && ok; ++i) {
+        QString path = QDir::toNativeSeparators(QFileInfo(imagePaths.at(i)).absoluteFilePath());
+        ok = SUCCEEDED(wallpaper->SetWallpaper(reinterpret_cast<LPCWSTR>(monitors.at(i).id.utf16()),
+                                               reinterpret_cast<LPCWSTR>(path.utf16())));
+    }
+    wallpaper->Release();
+    return ok;
+}
+
+bool setLockScreenWallpaper(const QString &imagePath)
+{
+    // Convert the relative path to absolute path if needed
+    QFileInfo fileInfo(imagePath);
+    QString absolutePath = fileInfo.absoluteFilePath();
+    
+    // Create registry key: HKEY_LOCAL_MACHINE\SOFTWARE\Microsoft\Windows\CurrentVersion\PersonalizationCSP
+    QSettings settings("HKEY_LOCAL_MACHINE\\SOFTWARE\\Microsoft\\Windows\\CurrentVersion\\PersonalizationCSP", 
+                       QSettings::NativeFormat);
+    
+    // Set the registry values
+    bool success = true;
+    
+    // Replace forward slashes with backslashes for Windows path
+    absolutePath.replace("/", "\\");
+    
+    try {
+        // Set the lock screen image path
+        settings.setValue("LockScreenImagePath", absolutePath);
+        
+        // Set the lock screen image URL (same as path for local files)
+        settings.setValue("LockScreenImageUrl", absolutePath);
+        
+        // Set the status to enabled (1)
+        settings.setValue("LockScreenImageStatus", 1);
+    }
+    catch (...) {
+        // If any error occurs, return false
+        success = false;
+
+    }
+
+    // 检测是否设置成功
+    if (settings.value("LockScreenImageStatus", 0).toInt() == 1) {
+        success = true;
+    } else {
+        success = false;
+    }
+    
+    return success;
+}
+
+bool clearLockScreenWallpaper()
+{
+    qDebug() << "clearLockScreenWallpaper";
+    // Create registry key: HKEY_LOCAL_MACHINE\SOFTWARE\Microsoft\Windows\CurrentVersion\PersonalizationCSP
+    QSettings settings("HKEY_LOCAL_MACHINE\\SOFTWARE\\Microsoft\\Windows\\CurrentVersion\\PersonalizationCSP", 
+                       QSettings::NativeFormat);
+    
+    bool success = true;
+    
+    try {
+        // Remove the lock screen image path
+        settings.remove("LockScreenImagePath");
+        
+        // Remove the lock screen image URL
+        settings.remove("LockScreenImageUrl");
+        
+        // Set the status to disabled (0)
+        settings.setValue("LockScreenImageStatus", 0);
+    }
+    catch (...) {
+        // If any error occurs, return false
+        success = false;
+    }
+
+    // 检测是否设置成功
+    if (settings.value("LockScreenImageStatus", 0).toInt() == 0) {
+        success = true;
+    } else {
+        success = false;
+    }
+    
+    return success;
+}
+
+void attachParentConsole()
+{
+    if (AttachConsole(ATTACH_PARENT_PROCESS)) {
+        freopen("CONOUT$", "w", stdout);
+        freopen("CONOUT$", "w", stderr);
+    }
+}
+
+qint64 msecsSinceProcessStart()
+{
+    FILETIME creation, exitTime, kernelTime, userTime, now;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exitTime, &kernelTime, &userTime)) {
+        return -1;
+    }
+    GetSystemTimeAsFileTime(&now);
+
+    // FILETIME以100纳秒为单位
+    ULARGE_INTEGER start, current;
+    start.LowPart = creation.dwLowDateTime;
+    start.HighPart = creation.dwHighDateTime;
+    current.LowPart = now.dwLowDateTime;
+    current.HighPart = now.dwHighDateTime;
+    return qint64(current.QuadPart - start.QuadPart) / 10000;
+}
+
+ProcessMemory processMemory()
+{
+    ProcessMemory memory;
+    PROCESS_MEMORY_COUNTERS_EX counters = {};
+    counters.cb = sizeof(counters);
+    if (GetProcessMemoryInfo(GetCurrentProcess(), reinterpret_cast<PROCESS_MEMORY_COUNTERS *>(&counters), sizeof(counters))) {
+        memory.workingSet = qint64(counters.WorkingSetSize);
+        memory.peakWorkingSet = qint64(counters.PeakWorkingSetSize);
+        memory.privateBytes = qint64(counters.PrivateUsage);
+    }
+    return memory;
+}
+
+QString processMemorySummary()
+{
+    const ProcessMemory memory = processMemory();
+    auto mb = [](qint64 bytes) {
+        return QString::number(bytes / (1024.0 * 1024.0), 'f', 1);
+    };
+    // 私有内存才反映实际释放了多少，工作集只作参考
+    return QString("memory: private %1 MB, working set %2 MB (peak %3 MB)")
+        .arg(mb(memory.privateBytes), mb(memory.workingSet), mb(memory.peakWorkingSet));
+}
+
+void trimProcessMemory()
+{
+    // 不清空工作集：那样只是把页面移出去，私有内存不变，再次打开时还要缺页取回
+    _heapmin();
+}
@@ -0,0 +1,42 @@
+#ifndef PLATFORM_H
+#define PLATFORM_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QRect>
+
+// 与界面无关的系统调用，界面和无界面模式共用
+
+struct DesktopMonitor {
+    QString id;  // IDesktopWallpaper使用的显示器设备路径
+    QRect rect;  // 物理像素，已包含缩放比例
+};
+
+// 设置桌面壁纸，所有显示器使用同一张图片
+bool setDesktopWallpaper(const QString &imagePath);
+// 当前连接的显示器，获取失败时为空
+QList<DesktopMonitor> desktopMonitors();
+// 为每个显示器设置各自的图片(与monitors一一对应)，以填充方式显示
+bool setMonitorWallpapers(const QList<DesktopMonitor> &monitors, const QStringList &imagePaths);
+// 通过注册表设置/清除锁屏壁纸，需要管理员权限
+bool setLockScreenWallpaper(const QString &imagePath);
+bool clearLockScreenWallpaper();
+
+// 程序以窗口程序编译，命令行模式下把输出接到启动它的控制台
+void attachParentConsole();
+// 自进程创建起经过的毫秒数，包括加载DLL等main之前的时间
+qint64 msecsSinceProcessStart();
+
+// 进程内存占用，获取失败时为-1
+struct ProcessMemory {
+    qint64 workingSet = -1;      // 常驻内存(RSS)
+    qint64 peakWorkingSet = -1;
+    qint64 privateBytes = -1;    // 已提交的私有内存，主要是堆
+};
+ProcessMemory processMemory();
+QString processMemorySummary();
+// 释放C运行库堆中的空闲内存；隐藏到托盘后调用
+void trimProcessMemory();
+
+#endif // PLATFORM_H
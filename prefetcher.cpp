@@ -0,0 +1,153 @@
+#include "prefetcher.h"
+#include "wallpaperfetcher.h"
+
+Prefetcher::Prefetcher(WallpaperFetcher *fetcher, QObject *parent)
+    : QObject(parent)
+    , fetcher(fetcher)
+{
+    connect(fetcher, &WallpaperFetcher::foregroundBusyChanged, this, &Prefetcher::onForegroundBusyChanged);
+}
+
+void Prefetcher::setRadius(int days)
+{
+    radius = days;
+}
+
+void Prefetcher::enqueue(const QDate &date)
+{
+    if (date < QDate(2010, 1, 1) || date > QDate::currentDate() || queue.contains(date)) {
+        return;
+    }
+    queue.append(date);
+}
+
+void Prefetcher::requeue(const QList<QDate> &dates)
+{
+    for (auto it = dates.crbegin(); it != dates.crend(); ++it) {
+        if (it->isValid() && !queue.contains(*it)) {
+            queue.prepend(*it);
+        }
+    }
+}
+
+void Prefetcher::prefetchAround(const QDate &selected, int shownYear, int shownMonth)
+{
+    queue.clear();
+
+    // 先由近及远预取选中日期前后的日期，再预取当前显示月份的其余日期
+    for (int offset = 1; offset <= radius; ++offset) {
+        enqueue(selected.addDays(offset));
+        enqueue(selected.addDays(-offset));
+    }
+    QDate firstDay(shownYear, shownMonth, 1);
+    for (int day = 0; day < firstDay.daysInMonth(); ++day) {
+        QDate date = firstDay.addDays(day);
+        if (date != selected) {
+            enqueue(date);
+        }
+    }
+
+    schedule();
+}
+
+void Prefetcher::cancel()
+{
+    abortInFlight(false);
+    queue.clear();
+}
+
+void Prefetcher::abortInFlight(bool keepPending)
+{
+    const QList<QPointer<QNetworkReply>> replies = inFlight;
+    inFlight.clear();
+    for (const QPointer<QNetworkReply> &reply : replies) {
+        if (!reply) {
+            continue;
+        }
+        reply->disconnect(this);
+        reply->abort();
+
+        // 被中止的日期放回队首，之后重新预取
+        if (keepPending) {
+            QString yearMonth = reply->property("prefetchMonth").toString();
+            if (!yearMonth.isEmpty()) {
+                warmedMonths.remove(yearMonth);
+                requeue(waitingForMonth.take(yearMonth));
+            } else {
+                requeue({reply->property("prefetchDate").toDate()});
+            }
+        }
+    }
+    if (!keepPending) {
+        waitingForMonth.clear();
+    }
+}
+
+void Prefetcher::onForegroundBusyChanged(bool busy)
+{
+    // 前台请求优先：中止后台请求，前台完成后再继续
+    if (busy) {
+        abortInFlight(true);
+    } else {
+        schedule();
+    }
+}
+
+void Prefetcher::track(QNetworkReply *reply)
+{
+    inFlight.append(reply);
+    connect(reply, &QNetworkReply::finished, this, [this, reply]() {
+        inFlight.removeIf([reply](const QPointer<QNetworkReply> &p) { return p.data() == reply; });
+
+        // 月份信息到达后，处理等待该月的日期
+        QString yearMonth = reply->property("prefetchMonth").toString();
+        if (!yearMonth.isEmpty()) {
+            QList<QDate> dates = waitingForMonth.take(yearMonth);
+            if (reply->error() == QNetworkReply::NoError) {
+                requeue(dates);
+            }
+        }
+        schedule();
+    });
+}
+
+void Prefetcher::schedule()
+{
+    inFlight.removeIf([](const QPointer<QNetworkReply> &p) { return p.isNull(); });
+
+    while (!fetcher->isForegroundBusy() && inFlight.size() < maxInFlight && !queue.isEmpty()) {
+        QDate date = queue.takeFirst();
+        QString dateStr = date.toString("yyyyMMdd");
+
+        QString imgtitle, imgurl;
+        if (fetcher->cachedMetadata(dateStr, &imgtitle, &imgurl)) {
+            // 预览图已缓存时warmPreview返回nullptr，直接处理下一个
+            if (QNetworkReply *reply = fetcher->warmPreview(imgurl)) {
+                reply->setProperty("prefetchDate", date);
+                track(reply);
+            }
+            continue;
+        }
+
+        // 该月正在获取，等其完成后再处理
+        QString yearMonth = date.toString("yyyyMM");
+        auto waiting = waitingForMonth.find(yearMonth);
+        if (waiting != waitingForMonth.end()) {
+            waiting->append(date);
+            continue;
+        }
+
+        // 每个月份只预取一次，获取后仍没有该日期数据则跳过
+        if (warmedMonths.contains(yearMonth)) {
+            continue;
+        }
+        QNetworkReply *reply = fetcher->warmMonth(yearMonth);
+        if (!reply) {
+            continue;
+        }
+        warmedMonths.insert(yearMonth);
+        waitingForMonth.insert(yearMonth, {date});
+        reply->setProperty("prefetchMonth", yearMonth);
+        track(reply);
+    }
+}
@@ -0,0 +1,48 @@
+#ifndef PREFETCHER_H
+#define PREFETCHER_H
+
+#include <QObject>
+#include <QDate>
+#include <QList>
+#include <QSet>
+#include <QHash>
+#include <QPointer>
+#include <QtNetwork/QNetworkReply>
+
+class WallpaperFetcher;
+
+// 后台预取：为当前选中日期前后若干天和日历当前显示的月份
+// 预先准备壁纸信息和预览图缓存，使下一次点击可以直接显示
+// 前台请求进行时暂停并中止后台请求，不与前台争用带宽
+class Prefetcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit Prefetcher(WallpaperFetcher *fetcher, QObject *parent = nullptr);
+
+    void setRadius(int days);
+    // 替换预取队列，已在进行中的请求继续完成
+    void prefetchAround(const QDate &selected, int shownYear, int shownMonth);
+    void cancel();
+
+private slots:
+    void onForegroundBusyChanged(bool busy);
+
+private:
+    void schedule();
+    void enqueue(const QDate &date);
+    void track(QNetworkReply *reply);
+    void requeue(const QList<QDate> &dates);
+    void abortInFlight(bool keepPending);
+
+    WallpaperFetcher *fetcher;
+    QList<QDate> queue;
+    QList<QPointer<QNetworkReply>> inFlight;
+    QSet<QString> warmedMonths;
+    QHash<QString, QList<QDate>> waitingForMonth;
+    int radius = 3;
+    int maxInFlight = 2;
+};
+
+#endif // PREFETCHER_H
@@ -0,0 +1,110 @@
+#include "previewcache.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QDateTime>
+#include <QStandardPaths>
+#include <QCryptographicHash>
+
+PreviewCache::PreviewCache(qint64 maxDiskBytes, int maxMemoryKBytes)
+    : maxDiskBytes(maxDiskBytes)
+{
+    pixmaps.setMaxCost(maxMemoryKBytes);
+    cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/preview";
+    QDir().mkpath(cacheDir);
+}
+
+QString PreviewCache::filePath(const QString &imgurl) const
+{
+    QByteArray hash = QCryptographicHash::hash(imgurl.toUtf8(), QCryptographicHash::Sha1).toHex();
+    return cacheDir + "/" + QString::fromLatin1(hash) + ".jpg";
+}
+
+QPixmap PreviewCache::pixmap(const QString &imgurl) const
+{
+    QPixmap *cached = pixmaps.object(imgurl);
+    return cached ? *cached : QPixmap();
+}
+
+void PreviewCache::insertPixmap(const QString &imgurl, const QPixmap &pixmap)
+{
+    if (pixmap.isNull()) {
+        return;
+    }
+    // 以KB为单位计算占用
+    int cost = qMax(1, int(qint64(pixmap.width()) * pixmap.height() * pixmap.depth() / 8 / 1024));
+    pixmaps.insert(imgurl, new QPixmap(pixmap), cost);
+}
+
+void PreviewCache::clearMemory()
+{
+    pixmaps.clear();
+}
+
+bool PreviewCache::contains(const QString &imgurl) const
+{
+    return QFile::exists(filePath(imgurl));
+}
+
+QByteArray PreviewCache::data(const QString &imgurl) const
+{
+    QFile file(filePath(imgurl));
+    if (!file.open(QIODevice::ReadWrite)) {
+        return QByteArray();
+    }
+
+    // 用修改时间记录最近访问，淘汰时先删除最久未访问的
+    file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+    return file.readAll();
+}
+
+void PreviewCache::insertData(const QString &imgurl, const QByteArray &data)
+{
+    if (data.isEmpty()) {
+        return;
+    }
+
+    QString path = filePath(imgurl);
+    qint64 oldSize = QFileInfo(path).size();
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return;
+    }
+    file.write(data);
+    if (!file.commit()) {
+        return;
+    }
+
+    if (diskBytes < 0) {
+        diskBytes = 0;
+        const QFileInfoList files = QDir(cacheDir).entryInfoList(QDir::Files);
+        for (const QFileInfo &info : files) {
+            diskBytes += info.size();
+        }
+    } else {
+        diskBytes += data.size() - oldSize;
+    }
+
+    if (diskBytes > maxDiskBytes) {
+        evict();
+    }
+}
+
+void PreviewCache::evict()
+{
+    // 按修改时间从旧到新删除，直到降到上限的3/4，避免频繁扫描目录
+    QDir dir(cacheDir);
+    QFileInfoList files = dir.entryInfoList(QDir::Files, QDir::Time | QDir::Reversed);
+    qint64 target = maxDiskBytes * 3 / 4;
+    for (const QFileInfo &info : std::as_const(files)) {
+        if (diskBytes <= target) {
+            break;
+        }
+        if (QFile::remove(info.absoluteFilePath())) {
+            diskBytes -= info.size();
+        }
+    }
+}
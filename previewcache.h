@@ -0,0 +1,37 @@
+#ifndef PREVIEWCACHE_H
+#define PREVIEWCACHE_H
+
+#include <QString>
+#include <QByteArray>
+#include <QPixmap>
+#include <QCache>
+
+// 预览图缓存，以图片url的哈希为键
+// 磁盘层保存下载的原始预览数据，按最近访问时间淘汰，总大小不超过上限；
+// 内存层保存已解码缩放好的QPixmap，再次查看同一日期时直接显示
+class PreviewCache
+{
+public:
+    explicit PreviewCache(qint64 maxDiskBytes = 64 * 1024 * 1024, int maxMemoryKBytes = 8 * 1024);
+
+    // 内存层
+    QPixmap pixmap(const QString &imgurl) const;
+    void insertPixmap(const QString &imgurl, const QPixmap &pixmap);
+    void clearMemory();
+
+    // 磁盘层
+    bool contains(const QString &imgurl) const;
+    QByteArray data(const QString &imgurl) const;
+    void insertData(const QString &imgurl, const QByteArray &data);
+
+private:
+    QString filePath(const QString &imgurl) const;
+    void evict();
+
+    QCache<QString, QPixmap> pixmaps;
+    QString cacheDir;
+    qint64 maxDiskBytes;
+    qint64 diskBytes = -1; // 首次写入时统计
+};
+
+#endif // PREVIEWCACHE_H
@@ -0,0 +1,73 @@
+#include "previewdecoder.h"
+#include "resampler.h"
+
+#include <QBuffer>
+#include <QImageReader>
+
+namespace {
+
+QImage readScaled(QImageReader &reader, const QSize &target)
+{
+    QSize size = reader.size();
+    if (size.isValid() && target.isValid() && (size.width() > target.width() || size.height() > target.height())) {
+        QSize scaledSize = size.scaled(target, Qt::KeepAspectRatio);
+        // 只请求解码器能在DCT阶段直接得到的尺寸(1/2、1/4、1/8)，剩余部分由Resampler缩放
+        int factor = 8;
+        while (factor > 1 && (size.width() / factor < scaledSize.width() || size.height() / factor < scaledSize.height())) {
+            factor /= 2;
+        }
+        if (factor > 1) {
+            reader.setScaledSize(QSize(size.width() / factor, size.height() / factor));
+        }
+    }
+    // 解码器输出向上取整，与请求的尺寸可能差1像素，这时快速缩放即可
+    reader.setQuality(0);
+
+    QImage image = reader.read();
+    // 读不到尺寸的格式同样在解码后缩放
+    if (!image.isNull() && (image.width() > target.width() || image.height() > target.height())) {
+        image = Resampler::scaled(image, image.size().scaled(target, Qt::KeepAspectRatio));
+    }
+    return image;
+}
+
+}
+
+PreviewDecoder::PreviewDecoder(ImageExecutor *executor, QObject *parent)
+    : QObject(parent)
+    , executor(executor)
+{
+}
+
+QImage PreviewDecoder::decodeScaled(const QByteArray &data, const QSize &target)
+{
+    QBuffer buffer;
+    buffer.setData(data);
+    buffer.open(QIODevice::ReadOnly);
+    QImageReader reader(&buffer);
+    return readScaled(reader, target);
+}
+
+QImage PreviewDecoder::decodeScaledFile(const QString &filePath, const QSize &target)
+{
+    QImageReader reader(filePath);
+    return readScaled(reader, target);
+}
+
+void PreviewDecoder::decode(const QString &imgurl, const QByteArray &data, const QSize &target)
+{
+    executor->run<QImage>(ImageExecutor::ForegroundPriority, this, [data, target]() {
+        return decodeScaled(data, target);
+    }, [this, imgurl](QImage image) {
+        emit decoded(imgurl, image);
+    });
+}
+
+void PreviewDecoder::decodeFile(const QString &imgurl, const QString &filePath, const QSize &target)
+{
+    executor->run<QImage>(ImageExecutor::ForegroundPriority, this, [filePath, target]() {
+        return decodeScaledFile(filePath, target);
+    }, [this, imgurl](QImage image) {
+        emit decoded(imgurl, image);
+    });
+}
@@ -0,0 +1,36 @@
+#ifndef PREVIEWDECODER_H
+#define PREVIEWDECODER_H
+
+#include <QObject>
+#include <QString>
+#include <QByteArray>
+#include <QImage>
+#include <QSize>
+#include "imageexecutor.h"
+
+// 在图片线程池中把预览图直接解码为显示尺寸
+// JPEG解码器按setScaledSize在DCT阶段缩小(1/2、1/4、1/8)，不再解码全部像素，剩余部分由Resampler缩放；
+// 从已存储的原图生成预览时差别尤其明显；结果为QImage，在界面线程转换为QPixmap
+class PreviewDecoder : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PreviewDecoder(ImageExecutor *executor, QObject *parent = nullptr);
+
+    // 保持宽高比缩放到不超过target
+    static QImage decodeScaled(const QByteArray &data, const QSize &target);
+    static QImage decodeScaledFile(const QString &filePath, const QSize &target);
+
+    // 用于主窗口的预览，以前台优先级执行；全部壁纸等后台解码在各自的任务中调用decodeScaled
+    void decode(const QString &imgurl, const QByteArray &data, const QSize &target);
+    void decodeFile(const QString &imgurl, const QString &filePath, const QSize &target);
+
+signals:
+    void decoded(const QString &imgurl, const QImage &image);
+
+private:
+    ImageExecutor *executor;
+};
+
+#endif // PREVIEWDECODER_H
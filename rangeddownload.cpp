@@ -0,0 +1,410 @@
+#include "rangeddownload.h"
+#include "fileutil.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QCryptographicHash>
+
+namespace {
+
+const qint64 chunkSize = 256 * 1024;
+
+// 用于If-Range的验证器：优先强ETag，其次Last-Modified；弱ETag不能用于If-Range
+QByteArray validatorOf(QNetworkReply *reply)
+{
+    QByteArray etag = reply->rawHeader("ETag").trimmed();
+    if (!etag.isEmpty() && !etag.startsWith("W/")) {
+        return etag;
+    }
+    return reply->rawHeader("Last-Modified").trimmed();
+}
+
+}
+
+RangedDownload::RangedDownload(QNetworkAccessManager *manager, const QUrl &url, const QString &filePath,
+                               QObject *parent)
+    : QObject(parent)
+    , manager(manager)
+    , url(url)
+    , filePath(filePath)
+{
+    // 分段文件以url区分，不同图片下载到同一目标文件时不会误续传
+    QFileInfo info(filePath);
+    QByteArray hash = QCryptographicHash::hash(url.toEncoded(), QCryptographicHash::Sha1).toHex().left(16);
+    partPrefix = info.absolutePath() + "/" + info.completeBaseName() + "-" + QString::fromLatin1(hash);
+
+    stallTimer.setSingleShot(true);
+    stallTimer.setInterval(8000);
+    connect(&stallTimer, &QTimer::timeout, this, [this]() {
+        fail(TimeoutError, tr("下载超时"));
+    });
+}
+
+RangedDownload::~RangedDownload()
+{
+    abortReplies();
+    clearSegments();
+}
+
+void RangedDownload::setMaxSegments(int count)
+{
+    maxSegments = qMax(1, count);
+}
+
+void RangedDownload::setMinSegmentSize(qint64 bytes)
+{
+    minSegmentSize = qMax<qint64>(1, bytes);
+}
+
+void RangedDownload::setStallTimeout(int msecs)
+{
+    stallTimer.setInterval(msecs);
+}
+
+QString RangedDownload::partPath(int index, int count) const
+{
+    return partPrefix + QString(".part%1of%2").arg(index).arg(count);
+}
+
+QString RangedDownload::validatorPath() const
+{
+    return partPrefix + ".validator";
+}
+
+QByteArray RangedDownload::savedValidator() const
+{
+    QFile file(validatorPath());
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+}
+
+void RangedDownload::saveValidator()
+{
+    // 没有验证器时删除记录，下次不续传这些分段
+    if (validator.isEmpty()) {
+        QFile::remove(validatorPath());
+        return;
+    }
+    QSaveFile file(validatorPath());
+    if (file.open(QIODevice::WriteOnly)) {
+        file.write(validator);
+        file.commit();
+    }
+}
+
+qint64 RangedDownload::receivedBytes() const
+{
+    qint64 received = 0;
+    for (const Segment &seg : segments) {
+        received += seg.file ? seg.file->size() : 0;
+    }
+    return received;
+}
+
+void RangedDownload::start()
+{
+    stopped = false;
+    // 超过设定时间没有收到任何数据才算超时，慢速网络下只要还在下载就不会被中断
+    stallTimer.start();
+    // 不探测时先沿用上次的验证器，由If-Range确认文件未变
+    validator = savedValidator();
+
+    if (maxSegments > 1) {
+        probe();
+    } else {
+        startSegments(-1, true);
+    }
+}
+
+void RangedDownload::abort()
+{
+    stopped = true;
+    stallTimer.stop();
+    abortReplies();
+    clearSegments();
+}
+
+void RangedDownload::probe()
+{
+    // 先获取文件大小和是否支持Range，再决定是否分段
+    QPointer<QNetworkReply> reply = manager->head(QNetworkRequest(url));
+    Segment probeSegment;
+    probeSegment.reply = reply;
+    segments.append(probeSegment);
+
+    connect(reply, &QNetworkReply::finished, this, [this, reply]() {
+        reply->deleteLater();
+        qint64 size = -1;
+        bool ranges = false;
+        if (reply->error() == QNetworkReply::NoError) {
+            bool ok = false;
+            size = reply->header(QNetworkRequest::ContentLengthHeader).toLongLong(&ok);
+            if (!ok || size <= 0) {
+                size = -1;
+            }
+            ranges = reply->rawHeader("Accept-Ranges").trimmed().toLower() == "bytes";
+            validator = validatorOf(reply);
+        }
+        // 探测失败时按单段下载
+        segments.clear();
+        startSegments(size, ranges);
+    });
+}
+
+void RangedDownload::startSegments(qint64 size, bool rangesSupported)
+{
+    totalSize = size;
+    int count = 1;
+    if (size > 0 && rangesSupported) {
+        count = int(qBound<qint64>(1, size / minSegmentSize, maxSegments));
+    }
+
+    // 清理同一url按其他分段数留下的分段文件；验证器缺失或与上次不同时
+    // 服务器上的文件可能已变化，已下载的分段全部丢弃，避免拼接新旧两份数据
+    const QByteArray saved = savedValidator();
+    const bool resumable = !validator.isEmpty() && validator == saved;
+    QFileInfo prefixInfo(partPrefix);
+    const QFileInfoList partFiles = QDir(prefixInfo.absolutePath())
+        .entryInfoList({prefixInfo.fileName() + ".part*"}, QDir::Files);
+    const QString suffix = QString("of%1").arg(count);
+    for (const QFileInfo &info : partFiles) {
+        if (!resumable || !info.fileName().endsWith(suffix)) {
+            QFile::remove(info.absoluteFilePath());
+        }
+    }
+    if (validator != saved) {
+        saveValidator();
+    }
+
+    clearSegments();
+    for (int i = 0; i < count; ++i) {
+        Segment seg;
+        if (size > 0) {
+            seg.start = size * i / count;
+            seg.end = size * (i + 1) / count - 1;
+        }
+        seg.file = new QFile(partPath(i, count));
+        segments.append(seg);
+        if (!seg.file->open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Unbuffered)) {
+            fail(WriteError, seg.file->errorString());
+            return;
+        }
+
+        // 已有数据超出区间说明文件已变化，重新下载该段
+        if (seg.end >= 0) {
+            qint64 length = seg.end - seg.start + 1;
+            if (seg.file->size() > length) {
+                seg.file->resize(0);
+            }
+            segments[i].done = seg.file->size() == length;
+        }
+    }
+
+    bool allDone = true;
+    for (int i = 0; i < segments.size(); ++i) {
+        if (!segments.at(i).done) {
+            allDone = false;
+            startSegment(i);
+        }
+    }
+    if (allDone) {
+        assemble();
+    }
+}
+
+void RangedDownload::startSegment(int index)
+{
+    Segment &seg = segments[index];
+    qint64 from = seg.start + seg.file->size();
+
+    QNetworkRequest request(url);
+    if (seg.end >= 0) {
+        request.setRawHeader("Range", "bytes=" + QByteArray::number(from) + "-" + QByteArray::number(seg.end));
+    } else if (from > 0) {
+        request.setRawHeader("Range", "bytes=" + QByteArray::number(from) + "-");
+    }
+    // 文件已变化时服务器返回完整的200响应，而不是拼接到旧数据后的区间
+    if (!validator.isEmpty() && (seg.end >= 0 || from > 0)) {
+        request.setRawHeader("If-Range", validator);
+    }
+
+    QNetworkReply *reply = manager->get(request);
+    // 限制接收缓冲区，内存占用与图片大小无关
+    reply->setReadBufferSize(chunkSize);
+    seg.reply = reply;
+    seg.checked = false;
+
+    connect(reply, &QNetworkReply::readyRead, this, [this, index]() {
+        onSegmentReadyRead(index);
+    });
+    connect(reply, &QNetworkReply::finished, this, [this, index]() {
+        onSegmentFinished(index);
+    });
+}
+
+void RangedDownload::onSegmentReadyRead(int index)
+{
+    Segment &seg = segments[index];
+    QNetworkReply *reply = seg.reply;
+    if (!reply) {
+        return;
+    }
+    stallTimer.start();
+
+    int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    // 出错的响应体不写入分段，由finished报告错误
+    if (status >= 400) {
+        reply->readAll();
+        return;
+    }
+    if (!seg.checked) {
+        seg.checked = true;
+        // 多段时任何非206响应都说明服务器忽略了Range(或If-Range不匹配)，返回的是完整文件
+        if (status != 206 && seg.end >= 0 && segments.size() > 1) {
+            abortReplies();
+            startSegments(-1, false);
+            return;
+        }
+        if (segments.size() == 1) {
+            // 单段时记录本次响应的验证器；200表示从头下载，丢弃已有数据
+            if (status == 200 && seg.file->size() > 0) {
+                seg.file->resize(0);
+            }
+            QByteArray current = validatorOf(reply);
+            if (status == 200 || current != validator) {
+                validator = current;
+                saveValidator();
+            }
+        }
+    }
+
+    QByteArray data = reply->readAll();
+    if (seg.file->write(data) != data.size()) {
+        fail(WriteError, seg.file->errorString());
+        return;
+    }
+    emit progress(receivedBytes(), totalSize);
+}
+
+void RangedDownload::onSegmentFinished(int index)
+{
+    QNetworkReply *reply = segments[index].reply;
+    if (!reply) {
+        return;
+    }
+    reply->deleteLater();
+
+    int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (reply->error() != QNetworkReply::NoError) {
+        // 416: 续传时已下载的数据就是完整文件
+        if (status != 416 || segments[index].end >= 0 || segments[index].file->size() == 0) {
+            fail(NetworkError, reply->errorString());
+            return;
+        }
+    } else {
+        // 处理剩余数据，可能因服务器忽略Range而重新开始
+        int segmentCount = segments.size();
+        onSegmentReadyRead(index);
+        if (stopped || segments.size() != segmentCount || !segments[index].file) {
+            return;
+        }
+    }
+
+    Segment &seg = segments[index];
+    seg.reply = nullptr;
+    if (seg.end >= 0 && seg.file->size() != seg.end - seg.start + 1) {
+        fail(NetworkError, tr("下载的数据不完整"));
+        return;
+    }
+    seg.done = true;
+
+    for (const Segment &other : std::as_const(segments)) {
+        if (!other.done) {
+            return;
+        }
+    }
+    assemble();
+}
+
+void RangedDownload::assemble()
+{
+    stallTimer.stop();
+    QStringList parts;
+    for (const Segment &seg : std::as_const(segments)) {
+        parts.append(seg.file->fileName());
+    }
+    clearSegments();
+
+    // 单段直接改名为目标文件
+    if (parts.size() == 1) {
+        if (!replaceFile(parts.first(), filePath)) {
+            fail(WriteError, tr("无法替换文件: ") + filePath);
+            return;
+        }
+        QFile::remove(validatorPath());
+        stopped = true;
+        emit finished();
+        return;
+    }
+
+    // 多段按顺序拼接到临时文件，完成后原子替换目标文件
+    QSaveFile out(filePath);
+    if (!out.open(QIODevice::WriteOnly)) {
+        fail(WriteError, out.errorString());
+        return;
+    }
+    for (const QString &part : std::as_const(parts)) {
+        QFile in(part);
+        if (!in.open(QIODevice::ReadOnly)) {
+            out.cancelWriting();
+            fail(WriteError, in.errorString());
+            return;
+        }
+        while (!in.atEnd()) {
+            out.write(in.read(chunkSize));
+        }
+    }
+    if (!out.commit()) {
+        fail(WriteError, out.errorString());
+        return;
+    }
+
+    for (const QString &part : std::as_const(parts)) {
+        QFile::remove(part);
+    }
+    QFile::remove(validatorPath());
+    stopped = true;
+    emit finished();
+}
+
+void RangedDownload::fail(Error error, const QString &errorString)
+{
+    if (stopped) {
+        return;
+    }
+    // 已下载的分段保留在磁盘上，下次续传
+    abort();
+    emit failed(error, errorString);
+}
+
+void RangedDownload::abortReplies()
+{
+    for (Segment &seg : segments) {
+        QNetworkReply *reply = seg.reply;
+        seg.reply = nullptr;
+        if (reply) {
+            reply->disconnect(this);
+            reply->abort();
+            reply->deleteLater();
+        }
+    }
+}
+
+void RangedDownload::clearSegments()
+{
+    for (Segment &seg : segments) {
+        delete seg.file;
+        seg.file = nullptr;
+    }
+    segments.clear();
+}
@@ -0,0 +1,86 @@
+#ifndef RANGEDDOWNLOAD_H
+#define RANGEDDOWNLOAD_H
+
+#include <QObject>
+#include <QString>
+#include <QUrl>
+#include <QList>
+#include <QFile>
+#include <QTimer>
+#include <QPointer>
+#include <QtNetwork/QNetworkAccessManager>
+#include <QtNetwork/QNetworkReply>
+
+// 支持断点续传和分段并行的文件下载
+// 已下载的数据保存在目标文件旁的分段文件(<url哈希>.part<i>of<n>)中，
+// 中断后再次下载同一url时用HTTP Range从已有字节继续，并以If-Range携带上次的ETag/Last-Modified，
+// 服务器上的文件变化或没有验证器时丢弃已有分段；
+// 较大的文件在服务器支持Range时拆成多个区间同时下载，完成后拼接并原子替换目标文件
+class RangedDownload : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Error {
+        NetworkError,
+        TimeoutError,
+        WriteError
+    };
+    Q_ENUM(Error)
+
+    RangedDownload(QNetworkAccessManager *manager, const QUrl &url, const QString &filePath,
+                   QObject *parent = nullptr);
+    ~RangedDownload();
+
+    void setMaxSegments(int count);
+    void setMinSegmentSize(qint64 bytes);
+    void setStallTimeout(int msecs);
+
+    void start();
+    // 中止下载，保留已下载的分段供下次续传
+    void abort();
+
+signals:
+    void progress(qint64 received, qint64 total);
+    void finished();
+    void failed(RangedDownload::Error error, const QString &errorString);
+
+private:
+    struct Segment {
+        qint64 start = 0;
+        qint64 end = -1;   // 包含end；-1表示总大小未知，下载到结束
+        QFile *file = nullptr;
+        QPointer<QNetworkReply> reply;
+        bool checked = false;
+        bool done = false;
+    };
+
+    void probe();
+    void startSegments(qint64 totalSize, bool rangesSupported);
+    void startSegment(int index);
+    void onSegmentReadyRead(int index);
+    void onSegmentFinished(int index);
+    void assemble();
+    void fail(Error error, const QString &errorString);
+    void abortReplies();
+    void clearSegments();
+    QString partPath(int index, int count) const;
+    QString validatorPath() const;
+    QByteArray savedValidator() const;
+    void saveValidator();
+    qint64 receivedBytes() const;
+
+    QNetworkAccessManager *manager;
+    QUrl url;
+    QString filePath;
+    QString partPrefix;
+    QList<Segment> segments;
+    QTimer stallTimer;
+    QByteArray validator;  // 分段数据所属文件的ETag或Last-Modified，保存在<前缀>.validator
+    qint64 totalSize = -1;
+    qint64 minSegmentSize = 2 * 1024 * 1024;
+    int maxSegments = 1;
+    bool stopped = false;
+};
+
+#endif // RANGEDDOWNLOAD_H
@@ -0,0 +1,378 @@
+#include "resampler.h"
+#include "cpufeatures.h"
+
+#include <QList>
+#include <QtMath>
+#include <cstring>
+
+namespace {
+
+// 权重的小数位数：像素(8位)乘权重再求和不会超出32位
+const int WeightBits = 14;
+const int WeightRound = 1 << (WeightBits - 1);
+
+// 每个输出像素(或行)对应一段连续的输入，长度统一补齐到4的倍数，补齐部分权重为0
+struct Coefficients {
+    int taps = 0;
+    QList<int> starts;
+    QList<qint16> weights;
+};
+
+double bicubic(double x)
+{
+    // a = -0.5，与Pillow、OpenCV相同
+    const double a = -0.5;
+    x = qAbs(x);
+    if (x < 1.0) {
+        return ((a + 2.0) * x - (a + 3.0)) * x * x + 1.0;
+    }
+    if (x < 2.0) {
+        return (((x - 5.0) * x + 8.0) * x - 4.0) * a;
+    }
+    return 0.0;
+}
+
+double sinc(double x)
+{
+    if (x == 0.0) {
+        return 1.0;
+    }
+    x *= M_PI;
+    return std::sin(x) / x;
+}
+
+double lanczos3(double x)
+{
+    return (x > -3.0 && x < 3.0) ? sinc(x) * sinc(x / 3.0) : 0.0;
+}
+
+Coefficients computeCoefficients(int inSize, int outSize, Resampler::Filter filter)
+{
+    const double scale = double(inSize) / outSize;
+    // 缩小时按比例展宽滤波器，起到低通作用
+    const double filterScale = qMax(1.0, scale);
+    const double support = (filter == Resampler::Lanczos3 ? 3.0 : 2.0) * filterScale;
+    double (*kernel)(double) = filter == Resampler::Lanczos3 ? lanczos3 : bicubic;
+
+    Coefficients c;
+    c.taps = (int(std::ceil(support)) * 2 + 1 + 3) & ~3;
+    c.starts.resize(outSize);
+    c.weights.fill(0, qsizetype(outSize) * c.taps);
+
+    QList<double> weights(c.taps);
+    for (int i = 0; i < outSize; ++i) {
+        const double center = (i + 0.5) * scale;
+        const int first = qMax(int(center - support + 0.5), 0);
+        const int last = qMin(int(center + support + 0.5), inSize);
+        const int count = qMin(last - first, c.taps);
+
+        double total = 0.0;
+        for (int k = 0; k < count; ++k) {
+            weights[k] = kernel((first + k - center + 0.5) / filterScale);
+            total += weights[k];
+        }
+
+        // 定点化后把舍入误差加到最大的权重上，保证权重和精确为1，纯色区域缩放后不变
+        qint16 *fixed = c.weights.data() + qsizetype(i) * c.taps;
+        int sum = 0;
+        int largest = 0;
+        for (int k = 0; k < count; ++k) {
+            fixed[k] = qint16(qRound(weights[k] / total * (1 << WeightBits)));
+            sum += fixed[k];
+            if (fixed[k] > fixed[largest]) {
+                largest = k;
+            }
+        }
+        fixed[largest] = qint16(fixed[largest] + (1 << WeightBits) - sum);
+        c.starts[i] = first;
+    }
+    return c;
+}
+
+inline uchar clampPixel(int value)
+{
+    value >>= WeightBits;
+    return uchar(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+// 水平：in为补齐过的一行(每像素4字节)，输出outSize个像素
+void horizontalScalar(const uchar *in, uchar *out, int outSize, const Coefficients &c)
+{
+    for (int x = 0; x < outSize; ++x) {
+        const uchar *src = in + c.starts.at(x) * 4;
+        const qint16 *w = c.weights.constData() + qsizetype(x) * c.taps;
+        int s0 = WeightRound, s1 = WeightRound, s2 = WeightRound, s3 = WeightRound;
+        for (int k = 0; k < c.taps; ++k) {
+            s0 += src[k * 4] * w[k];
+            s1 += src[k * 4 + 1] * w[k];
+            s2 += src[k * 4 + 2] * w[k];
+            s3 += src[k * 4 + 3] * w[k];
+        }
+        out[x * 4] = clampPixel(s0);
+        out[x * 4 + 1] = clampPixel(s1);
+        out[x * 4 + 2] = clampPixel(s2);
+        out[x * 4 + 3] = clampPixel(s3);
+    }
+}
+
+// 垂直：rows为参与计算的taps行，逐字节求加权和
+void verticalScalar(const uchar *const *rows, const qint16 *w, int taps, uchar *out, int from, int bytes)
+{
+    for (int i = from; i < bytes; ++i) {
+        int s = WeightRound;
+        for (int k = 0; k < taps; ++k) {
+            s += rows[k][i] * w[k];
+        }
+        out[i] = clampPixel(s);
+    }
+}
+
+#if defined(Q_PROCESSOR_X86)
+
+// 两个相邻权重组成madd使用的(w0, w1)对
+inline int weightPair(const qint16 *w)
+{
+    int pair;
+    std::memcpy(&pair, w, sizeof(pair));
+    return pair;
+}
+
+void horizontalSse2(const uchar *in, uchar *out, int outSize, const Coefficients &c)
+{
+    const __m128i zero = _mm_setzero_si128();
+    for (int x = 0; x < outSize; ++x) {
+        const uchar *src = in + c.starts.at(x) * 4;
+        const qint16 *w = c.weights.constData() + qsizetype(x) * c.taps;
+        __m128i acc = _mm_set1_epi32(WeightRound);
+        for (int k = 0; k < c.taps; k += 4) {
+            // 4个像素展开为16位，再把相邻两个像素的同一通道交错排列，madd一次算两个权重
+            __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + k * 4));
+            __m128i lo = _mm_unpacklo_epi8(pixels, zero);
+            __m128i hi = _mm_unpackhi_epi8(pixels, zero);
+            lo = _mm_unpacklo_epi16(lo, _mm_srli_si128(lo, 8));
+            hi = _mm_unpacklo_epi16(hi, _mm_srli_si128(hi, 8));
+            __m128i weights = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(w + k));
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(lo, _mm_shuffle_epi32(weights, 0x00)));
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(hi, _mm_shuffle_epi32(weights, 0x55)));
+        }
+        acc = _mm_srai_epi32(acc, WeightBits);
+        acc = _mm_packs_epi32(acc, acc);
+        acc = _mm_packus_epi16(acc, acc);
+        int pixel = _mm_cvtsi128_si32(acc);
+        std::memcpy(out + x * 4, &pixel, sizeof(pixel));
+    }
+}
+
+void verticalSse2(const uchar *const *rows, const qint16 *w, int taps, uchar *out, int from, int bytes)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i round = _mm_set1_epi32(WeightRound);
+    int i = from;
+    for (; i + 16 <= bytes; i += 16) {
+        __m128i acc0 = round, acc1 = round, acc2 = round, acc3 = round;
+        for (int k = 0; k < taps; k += 2) {
+            // 两行的同一字节交错排列，madd一次算两行
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rows[k] + i));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rows[k + 1] + i));
+            __m128i weights = _mm_set1_epi32(weightPair(w + k));
+            __m128i alo = _mm_unpacklo_epi8(a, zero);
+            __m128i blo = _mm_unpacklo_epi8(b, zero);
+            __m128i ahi = _mm_unpackhi_epi8(a, zero);
+            __m128i bhi = _mm_unpackhi_epi8(b, zero);
+            acc0 = _mm_add_epi32(acc0, _mm_madd_epi16(_mm_unpacklo_epi16(alo, blo), weights));
+            acc1 = _mm_add_epi32(acc1, _mm_madd_epi16(_mm_unpackhi_epi16(alo, blo), weights));
+            acc2 = _mm_add_epi32(acc2, _mm_madd_epi16(_mm_unpacklo_epi16(ahi, bhi), weights));
+            acc3 = _mm_add_epi32(acc3, _mm_madd_epi16(_mm_unpackhi_epi16(ahi, bhi), weights));
+        }
+        __m128i lo = _mm_packs_epi32(_mm_srai_epi32(acc0, WeightBits), _mm_srai_epi32(acc1, WeightBits));
+        __m128i hi = _mm_packs_epi32(_mm_srai_epi32(acc2, WeightBits), _mm_srai_epi32(acc3, WeightBits));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_packus_epi16(lo, hi));
+    }
+    verticalScalar(rows, w, taps, out, i, bytes);
+}
+
+CPU_TARGET_AVX2 void horizontalAvx2(const uchar *in, uchar *out, int outSize, const Coefficients &c)
+{
+    // 两个128位通道各处理两个像素，权重按通道排列为(w0,w1)x4和(w2,w3)x4
+    const __m256i weightIndex = _mm256_setr_epi32(0, 0, 0, 0, 1, 1, 1, 1);
+    for (int x = 0; x < outSize; ++x) {
+        const uchar *src = in + c.starts.at(x) * 4;
+        const qint16 *w = c.weights.constData() + qsizetype(x) * c.taps;
+        __m256i acc = _mm256_setzero_si256();
+        for (int k = 0; k < c.taps; k += 4) {
+            __m256i pixels = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + k * 4)));
+            pixels = _mm256_unpacklo_epi16(pixels, _mm256_srli_si256(pixels, 8));
+            __m256i weights = _mm256_castsi128_si256(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(w + k)));
+            weights = _mm256_permutevar8x32_epi32(weights, weightIndex);
+            acc = _mm256_add_epi32(acc, _mm256_madd_epi16(pixels, weights));
+        }
+        __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+        sum = _mm_srai_epi32(_mm_add_epi32(sum, _mm_set1_epi32(WeightRound)), WeightBits);
+        sum = _mm_packs_epi32(sum, sum);
+        sum = _mm_packus_epi16(sum, sum);
+        int pixel = _mm_cvtsi128_si32(sum);
+        std::memcpy(out + x * 4, &pixel, sizeof(pixel));
+    }
+}
+
+CPU_TARGET_AVX2 void verticalAvx2(const uchar *const *rows, const qint16 *w, int taps, uchar *out, int from, int bytes)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i round = _mm256_set1_epi32(WeightRound);
+    int i = from;
+    for (; i + 32 <= bytes; i += 32) {
+        // 与SSE2相同，unpack和pack都在各自的128位通道内进行，最终顺序不变
+        __m256i acc0 = round, acc1 = round, acc2 = round, acc3 = round;
+        for (int k = 0; k < taps; k += 2) {
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(rows[k] + i));
+            __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(rows[k + 1] + i));
+            __m256i weights = _mm256_set1_epi32(weightPair(w + k));
+            __m256i alo = _mm256_unpacklo_epi8(a, zero);
+            __m256i blo = _mm256_unpacklo_epi8(b, zero);
+            __m256i ahi = _mm256_unpackhi_epi8(a, zero);
+            __m256i bhi = _mm256_unpackhi_epi8(b, zero);
+            acc0 = _mm256_add_epi32(acc0, _mm256_madd_epi16(_mm256_unpacklo_epi16(alo, blo), weights));
+            acc1 = _mm256_add_epi32(acc1, _mm256_madd_epi16(_mm256_unpackhi_epi16(alo, blo), weights));
+            acc2 = _mm256_add_epi32(acc2, _mm256_madd_epi16(_mm256_unpacklo_epi16(ahi, bhi), weights));
+            acc3 = _mm256_add_epi32(acc3, _mm256_madd_epi16(_mm256_unpackhi_epi16(ahi, bhi), weights));
+        }
+        __m256i lo = _mm256_packs_epi32(_mm256_srai_epi32(acc0, WeightBits), _mm256_srai_epi32(acc1, WeightBits));
+        __m256i hi = _mm256_packs_epi32(_mm256_srai_epi32(acc2, WeightBits), _mm256_srai_epi32(acc3, WeightBits));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), _mm256_packus_epi16(lo, hi));
+    }
+    verticalSse2(rows, w, taps, out, i, bytes);
+}
+
+#endif // Q_PROCESSOR_X86
+
+using HorizontalPass = void (*)(const uchar *, uchar *, int, const Coefficients &);
+using VerticalPass = void (*)(const uchar *const *, const qint16 *, int, uchar *, int, int);
+
+QImage resampleHorizontal(const QImage &image, int width, Resampler::Filter filter, HorizontalPass pass)
+{
+    const Coefficients c = computeCoefficients(image.width(), width, filter);
+    QImage result(width, image.height(), image.format());
+    if (result.isNull()) {
+        return result;
+    }
+
+    // 每行复制到末尾补零的缓冲区，SIMD按4个像素读取时不会越界
+    QList<uchar> row((qsizetype(image.width()) + c.taps) * 4, 0);
+    for (int y = 0; y < image.height(); ++y) {
+        std::memcpy(row.data(), image.constScanLine(y), size_t(image.width()) * 4);
+        pass(row.constData(), result.scanLine(y), width, c);
+    }
+    return result;
+}
+
+QImage resampleVertical(const QImage &image, int height, Resampler::Filter filter, VerticalPass pass)
+{
+    const Coefficients c = computeCoefficients(image.height(), height, filter);
+    QImage result(image.width(), height, image.format());
+    if (result.isNull()) {
+        return result;
+    }
+
+    // 补齐部分权重为0，行号限制在图片内即可
+    QList<const uchar *> rows(c.taps);
+    const int bytes = image.width() * 4;
+    for (int y = 0; y < height; ++y) {
+        for (int k = 0; k < c.taps; ++k) {
+            rows[k] = image.constScanLine(qMin(c.starts.at(y) + k, image.height() - 1));
+        }
+        pass(rows.constData(), c.weights.constData() + qsizetype(y) * c.taps, c.taps, result.scanLine(y), 0, bytes);
+    }
+    return result;
+}
+
+// 负权重可能使预乘后的颜色超过alpha，限制回有效范围
+void clampPremultiplied(QImage &image)
+{
+    for (int y = 0; y < image.height(); ++y) {
+        QRgb *line = reinterpret_cast<QRgb *>(image.scanLine(y));
+        for (int x = 0; x < image.width(); ++x) {
+            const int a = qAlpha(line[x]);
+            line[x] = qRgba(qMin(qRed(line[x]), a), qMin(qGreen(line[x]), a), qMin(qBlue(line[x]), a), a);
+        }
+    }
+}
+
+}
+
+Resampler::Isa Resampler::bestIsa()
+{
+#if defined(Q_PROCESSOR_X86)
+    // Qt 6在x86上要求SSE2
+    static const Isa isa = cpuHasAvx2() ? Avx2Isa : Sse2Isa;
+    return isa;
+#else
+    return ScalarIsa;
+#endif
+}
+
+const char *Resampler::isaName(Isa isa)
+{
+    switch (isa) {
+    case Avx2Isa:
+        return "avx2";
+    case Sse2Isa:
+        return "sse2";
+    default:
+        return "scalar";
+    }
+}
+
+QImage Resampler::scaled(const QImage &image, const QSize &size, Filter filter)
+{
+    return scaled(image, size, filter, bestIsa());
+}
+
+QImage Resampler::scaled(const QImage &image, const QSize &size, Filter filter, Isa isa)
+{
+    if (image.isNull() || size.isEmpty()) {
+        return QImage();
+    }
+
+    // 统一为每像素4字节，各通道按相同方式计算
+    QImage source = image.convertToFormat(image.hasAlphaChannel() ? QImage::Format_ARGB32_Premultiplied
+                                                                  : QImage::Format_RGB32);
+    if (source.size() == size) {
+        return source;
+    }
+
+    HorizontalPass horizontal = horizontalScalar;
+    VerticalPass vertical = verticalScalar;
+#if defined(Q_PROCESSOR_X86)
+    isa = qMin(isa, bestIsa());
+    if (isa == Avx2Isa) {
+        horizontal = horizontalAvx2;
+        vertical = verticalAvx2;
+    } else if (isa == Sse2Isa) {
+        horizontal = horizontalSse2;
+        vertical = verticalSse2;
+    }
+#else
+    Q_UNUSED(isa);
+#endif
+
+    // 尺寸不变的方向跳过；先做缩小比例更大的方向，减少另一方向要处理的像素
+    QImage result = source;
+    const bool horizontalFirst = double(size.width()) / source.width() <= double(size.height()) / source.height();
+    for (int pass = 0; pass < 2; ++pass) {
+        if ((pass == 0) == horizontalFirst) {
+            if (result.width() != size.width()) {
+                result = resampleHorizontal(result, size.width(), filter, horizontal);
+            }
+        } else if (result.height() != size.height()) {
+            result = resampleVertical(result, size.height(), filter, vertical);
+        }
+        if (result.isNull()) {
+            return result;
+        }
+    }
+
+    if (result.format() == QImage::Format_ARGB32_Premultiplied) {
+        clampPremultiplied(result);
+    }
+    return result;
+}
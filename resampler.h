@@ -0,0 +1,33 @@
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include <QImage>
+#include <QSize>
+
+// 可分离的高质量缩放：先水平后垂直，每个方向的权重预先计算为14位定点数
+// 运行时按CPU选择AVX2/SSE2实现，其他平台使用标量实现，各实现的结果逐字节相同；
+// 预览、缩略图和显示器壁纸的生成都使用它，代替Qt::SmoothTransformation。可在任意线程调用
+class Resampler
+{
+public:
+    enum Filter {
+        Bicubic,
+        Lanczos3
+    };
+    enum Isa {
+        ScalarIsa,
+        Sse2Isa,
+        Avx2Isa
+    };
+
+    // 当前CPU支持的最快实现
+    static Isa bestIsa();
+    static const char *isaName(Isa isa);
+
+    // 缩放到size(不保持宽高比)，结果为RGB32或ARGB32_Premultiplied；
+    // isa超出CPU支持时使用bestIsa()
+    static QImage scaled(const QImage &image, const QSize &size, Filter filter = Lanczos3);
+    static QImage scaled(const QImage &image, const QSize &size, Filter filter, Isa isa);
+};
+
+#endif // RESAMPLER_H
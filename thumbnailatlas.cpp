@@ -0,0 +1,93 @@
+#include "thumbnailatlas.h"
+#include "resampler.h"
+
+ThumbnailAtlas::ThumbnailAtlas(const QSize &cellSize, qint64 memoryBudget, const QSize &pageSize)
+    : cell(cellSize)
+    , page(pageSize.expandedTo(cellSize))
+{
+    cellsPerPage = (page.width() / cell.width()) * (page.height() / cell.height());
+    const qint64 pageBytes = qint64(page.width()) * page.height() * 4;
+    maxPages = int(qMax<qint64>(1, memoryBudget / pageBytes));
+}
+
+qint64 ThumbnailAtlas::memoryBytes() const
+{
+    return qint64(pages.size()) * page.width() * page.height() * 4;
+}
+
+QRect ThumbnailAtlas::slotRect(int slot) const
+{
+    const int index = slot % cellsPerPage;
+    const int columns = page.width() / cell.width();
+    return QRect(QPoint(index % columns * cell.width(), index / columns * cell.height()), cell);
+}
+
+int ThumbnailAtlas::takeSlot()
+{
+    // 先用已分配页中的空格子，再分配新页，最后替换最久未画过的
+    for (int slot = 0; slot < keyOfSlot.size(); ++slot) {
+        if (keyOfSlot.at(slot) < 0) {
+            return slot;
+        }
+    }
+    if (pages.size() < maxPages) {
+        QImage image(page, QImage::Format_RGB32);
+        image.fill(Qt::black);
+        pages.append(image);
+        keyOfSlot.resize(pages.size() * cellsPerPage, -1);
+        lastUse.resize(keyOfSlot.size(), 0);
+        return int(keyOfSlot.size()) - cellsPerPage;
+    }
+    int oldest = 0;
+    for (int slot = 1; slot < lastUse.size(); ++slot) {
+        if (lastUse.at(slot) < lastUse.at(oldest)) {
+            oldest = slot;
+        }
+    }
+    slotOfKey.remove(keyOfSlot.at(oldest));
+    keyOfSlot[oldest] = -1;
+    return oldest;
+}
+
+void ThumbnailAtlas::insert(qint64 key, const QImage &thumbnail)
+{
+    if (thumbnail.isNull()) {
+        return;
+    }
+    int slot = slotOfKey.value(key, -1);
+    if (slot < 0) {
+        slot = takeSlot();
+        slotOfKey.insert(key, slot);
+        keyOfSlot[slot] = key;
+    }
+    lastUse[slot] = ++useCounter;
+
+    QSize size = thumbnail.size().scaled(cell, Qt::KeepAspectRatio);
+    QImage scaled = size == thumbnail.size() ? thumbnail : Resampler::scaled(thumbnail, size, Resampler::Bicubic);
+    const QRect rect = slotRect(slot);
+    QPainter painter(&pages[slot / cellsPerPage]);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    painter.fillRect(rect, Qt::black);
+    painter.drawImage(rect.topLeft() + QPoint((cell.width() - size.width()) / 2, (cell.height() - size.height()) / 2), scaled);
+}
+
+bool ThumbnailAtlas::draw(QPainter *painter, const QRect &target, qint64 key)
+{
+    const int slot = slotOfKey.value(key, -1);
+    if (slot < 0) {
+        return false;
+    }
+    lastUse[slot] = ++useCounter;
+    painter->drawImage(target, pages.at(slot / cellsPerPage), slotRect(slot));
+    return true;
+}
+
+void ThumbnailAtlas::clear()
+{
+    pages.clear();
+    pages.squeeze();
+    slotOfKey.clear();
+    slotOfKey.squeeze();
+    keyOfSlot.clear();
+    lastUse.clear();
+}
@@ -0,0 +1,49 @@
+#ifndef THUMBNAILATLAS_H
+#define THUMBNAILATLAS_H
+
+#include <QImage>
+#include <QSize>
+#include <QRect>
+#include <QList>
+#include <QHash>
+#include <QPainter>
+
+// 固定大小的缩略图共用少数几张大图(页)，每张缩略图占一个格子
+// 页按需分配，总数不超过内存预算；满了以后替换最久没有画过的格子，
+// 所以无论浏览多少个月，内存占用都不变。只在界面线程使用
+class ThumbnailAtlas
+{
+public:
+    // 预算不足一页时仍分配一页
+    explicit ThumbnailAtlas(const QSize &cellSize, qint64 memoryBudget = 16 * 1024 * 1024,
+                            const QSize &pageSize = QSize(1024, 1024));
+
+    QSize cellSize() const { return cell; }
+    // 最多可同时保存的缩略图数量，应大于一屏能显示的数量
+    int capacity() const { return maxPages * cellsPerPage; }
+    qint64 memoryBytes() const;
+
+    bool contains(qint64 key) const { return slotOfKey.contains(key); }
+    // 缩放到格子大小后放入(宽高比不同时居中)，可能替换最久未用的缩略图
+    void insert(qint64 key, const QImage &thumbnail);
+    // 画到target，没有该缩略图时返回false
+    bool draw(QPainter *painter, const QRect &target, qint64 key);
+    // 释放所有页
+    void clear();
+
+private:
+    int takeSlot();
+    QRect slotRect(int slot) const;
+
+    QSize cell;
+    QSize page;
+    int cellsPerPage;
+    int maxPages;
+    QList<QImage> pages;
+    QHash<qint64, int> slotOfKey;
+    QList<qint64> keyOfSlot;   // -1为空
+    QList<quint64> lastUse;
+    quint64 useCounter = 0;
+};
+
+#endif // THUMBNAILATLAS_H
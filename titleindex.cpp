@@ -0,0 +1,316 @@
+#include "titleindex.h"
+#include "archiveindex.h"
+
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QtMath>
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <numeric>
+
+namespace {
+
+const quint32 indexMagic = 0x4954424d; // "MBTI"
+const quint32 indexVersion = 1;
+
+bool isCjk(QChar c)
+{
+    const ushort u = c.unicode();
+    return (u >= 0x4e00 && u <= 0x9fff) || (u >= 0x3400 && u <= 0x4dbf)  // 汉字
+        || (u >= 0x3040 && u <= 0x30ff)                                  // 平假名、片假名
+        || (u >= 0xac00 && u <= 0xd7af);                                 // 韩文
+}
+
+void writeVarint(QByteArray &out, quint32 value)
+{
+    while (value >= 0x80) {
+        out.append(char(value | 0x80));
+        value >>= 7;
+    }
+    out.append(char(value));
+}
+
+bool readVarint(const char *&p, const char *end, quint32 *value)
+{
+    quint32 result = 0;
+    for (int shift = 0; p < end && shift < 32; shift += 7) {
+        const uchar byte = uchar(*p++);
+        result |= quint32(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+// 两个升序列表的交集
+QList<quint16> intersect(const QList<quint16> &a, const QList<quint16> &b)
+{
+    QList<quint16> result;
+    std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(result));
+    return result;
+}
+
+}
+
+TitleIndex::TitleIndex(const QString &filePath)
+    : filePath(filePath)
+{
+    if (this->filePath.isEmpty()) {
+        QString dataDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+        QDir().mkpath(dataDir);
+        this->filePath = dataDir + "/titles.idx";
+    }
+    load();
+}
+
+int TitleIndex::dayOffset(const QDate &date)
+{
+    const qint64 offset = ArchiveIndex::firstDate().daysTo(date);
+    return offset >= 0 && offset <= 0xffff ? int(offset) : -1;
+}
+
+QList<TitleIndex::Token> TitleIndex::tokenize(const QString &text, bool query)
+{
+    // 兼容分解后去掉重音符号，全角字母数字也变为半角
+    const QString folded = text.normalized(QString::NormalizationForm_KD).toCaseFolded();
+
+    QList<Token> tokens;
+    QString word;
+    QString cjkRun;
+    auto flushWord = [&tokens, &word](bool prefix) {
+        if (!word.isEmpty()) {
+            tokens.append(Token{word, prefix});
+            word.clear();
+        }
+    };
+    auto flushCjk = [&tokens, &cjkRun, query]() {
+        if (cjkRun.size() == 1 || (!query && !cjkRun.isEmpty())) {
+            for (QChar c : std::as_const(cjkRun)) {
+                tokens.append(Token{QString(c), false});
+            }
+        }
+        for (qsizetype i = 0; i + 1 < cjkRun.size(); ++i) {
+            tokens.append(Token{cjkRun.mid(i, 2), false});
+        }
+        cjkRun.clear();
+    };
+
+    for (QChar c : folded) {
+        if (c.category() == QChar::Mark_NonSpacing) {
+            continue;
+        }
+        if (isCjk(c)) {
+            flushWord(false);
+            cjkRun.append(c);
+        } else if (c.isLetterOrNumber()) {
+            flushCjk();
+            word.append(c);
+        } else {
+            flushWord(false);
+            flushCjk();
+        }
+    }
+    // 查询末尾还在输入的单词按前缀匹配
+    flushWord(query);
+    flushCjk();
+    return tokens;
+}
+
+void TitleIndex::load()
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    const QByteArray data = file.readAll();
+    if (data.size() < qsizetype(sizeof(Header))) {
+        return;
+    }
+
+    Header header;
+    std::memcpy(&header, data.constData(), sizeof(Header));
+    if (header.magic != indexMagic || header.version != indexVersion
+        || data.size() < qsizetype(sizeof(Header) + header.dayCount)) {
+        return;
+    }
+
+    const char *p = data.constData() + sizeof(Header);
+    const char *end = data.constData() + data.size();
+    QList<quint8> counts(header.dayCount);
+    std::memcpy(counts.data(), p, header.dayCount);
+    p += header.dayCount;
+
+    // 每个词: 长度 | UTF-8 | 日期数 | 日期差值...
+    QHash<QString, QList<quint16>> loaded;
+    loaded.reserve(header.termCount);
+    for (quint32 t = 0; t < header.termCount; ++t) {
+        quint32 length = 0;
+        quint32 count = 0;
+        if (!readVarint(p, end, &length) || end - p < qint64(length)) {
+            return;
+        }
+        QString term = QString::fromUtf8(p, length);
+        p += length;
+        if (!readVarint(p, end, &count)) {
+            return;
+        }
+        QList<quint16> days;
+        days.reserve(count);
+        quint32 day = 0;
+        for (quint32 i = 0; i < count; ++i) {
+            quint32 delta = 0;
+            if (!readVarint(p, end, &delta)) {
+                return;
+            }
+            day += delta;
+            days.append(quint16(day));
+        }
+        loaded.insert(term, days);
+    }
+
+    postings = std::move(loaded);
+    tokenCounts = std::move(counts);
+}
+
+bool TitleIndex::commit()
+{
+    if (!dirty) {
+        return true;
+    }
+
+    Header header = {indexMagic, indexVersion, quint32(postings.size()), quint32(tokenCounts.size())};
+    QByteArray data(reinterpret_cast<const char *>(&header), sizeof(Header));
+    data.append(reinterpret_cast<const char *>(tokenCounts.constData()), tokenCounts.size());
+    for (auto it = postings.constBegin(); it != postings.constEnd(); ++it) {
+        const QByteArray term = it.key().toUtf8();
+        writeVarint(data, quint32(term.size()));
+        data.append(term);
+        writeVarint(data, quint32(it->size()));
+        quint32 previous = 0;
+        for (quint16 day : *it) {
+            writeVarint(data, day - previous);
+            previous = day;
+        }
+    }
+
+    QSaveFile file(filePath);
+    bool written = file.open(QIODevice::WriteOnly) && file.write(data) == data.size() && file.commit();
+    if (written) {
+        dirty = false;
+    }
+    return written;
+}
+
+bool TitleIndex::contains(const QDate &date) const
+{
+    const int offset = dayOffset(date);
+    return offset >= 0 && offset < tokenCounts.size() && tokenCounts.at(offset) > 0;
+}
+
+void TitleIndex::insert(const QDate &date, const QString &title)
+{
+    const int offset = dayOffset(date);
+    if (offset < 0 || contains(date)) {
+        return;
+    }
+
+    const QList<Token> tokens = tokenize(title);
+    for (const Token &token : tokens) {
+        QList<quint16> &days = postings[token.text];
+        if (days.isEmpty()) {
+            sortedTerms.clear();
+        }
+        // 同一标题中重复的词只记一次；日期大多按顺序加入，通常直接追加在末尾
+        auto pos = std::lower_bound(days.begin(), days.end(), quint16(offset));
+        if (pos == days.end() || *pos != offset) {
+            days.insert(pos, quint16(offset));
+        }
+    }
+
+    if (offset >= tokenCounts.size()) {
+        tokenCounts.resize(offset + 1, 0);
+    }
+    tokenCounts[offset] = quint8(qBound<qsizetype>(1, tokens.size(), 255));
+    dirty = true;
+}
+
+QList<quint16> TitleIndex::prefixPostings(const QString &prefix) const
+{
+    if (sortedTerms.isEmpty() && !postings.isEmpty()) {
+        sortedTerms = postings.keys();
+        std::sort(sortedTerms.begin(), sortedTerms.end());
+    }
+
+    QList<quint16> result;
+    for (auto it = std::lower_bound(sortedTerms.cbegin(), sortedTerms.cend(), prefix);
+         it != sortedTerms.cend() && it->startsWith(prefix); ++it) {
+        const QList<quint16> days = postings.value(*it);
+        QList<quint16> merged;
+        std::set_union(result.begin(), result.end(), days.begin(), days.end(), std::back_inserter(merged));
+        result.swap(merged);
+    }
+    return result;
+}
+
+QList<TitleIndex::Match> TitleIndex::search(const QString &query, int limit) const
+{
+    const QList<Token> tokens = tokenize(query, true);
+    if (tokens.isEmpty()) {
+        return {};
+    }
+
+    // 每个查询词的日期列表，前缀词为所有以它开头的词的并集
+    const double total = qMax<qsizetype>(1, tokenCounts.size() - std::count(tokenCounts.begin(), tokenCounts.end(), 0));
+    QList<QList<quint16>> lists;
+    QList<double> weights;
+    for (const Token &token : tokens) {
+        QList<quint16> days = token.prefix ? prefixPostings(token.text) : postings.value(token.text);
+        if (days.isEmpty()) {
+            return {};
+        }
+        weights.append(std::log(1.0 + total / days.size()));
+        lists.append(days);
+    }
+
+    // 从最短的列表开始求交集
+    QList<int> order(lists.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&lists](int a, int b) {
+        return lists.at(a).size() < lists.at(b).size();
+    });
+    QList<quint16> days = lists.at(order.first());
+    for (int i = 1; i < order.size() && !days.isEmpty(); ++i) {
+        days = intersect(days, lists.at(order.at(i)));
+    }
+
+    // 相关度: 查询词的idf之和，前缀只匹配到较长的词时打折；再按标题长度归一，越短越相关
+    QList<Match> matches;
+    matches.reserve(days.size());
+    for (quint16 day : std::as_const(days)) {
+        double score = 0.0;
+        for (qsizetype i = 0; i < tokens.size(); ++i) {
+            double weight = weights.at(i);
+            if (tokens.at(i).prefix) {
+                const QList<quint16> exact = postings.value(tokens.at(i).text);
+                if (!std::binary_search(exact.begin(), exact.end(), day)) {
+                    weight *= 0.7;
+                }
+            }
+            score += weight;
+        }
+        score /= std::sqrt(double(tokenCounts.at(day)));
+        matches.append(Match{ArchiveIndex::firstDate().addDays(day), score});
+    }
+
+    limit = int(qMin<qsizetype>(qMax(0, limit), matches.size()));
+    std::partial_sort(matches.begin(), matches.begin() + limit, matches.end(), [](const Match &a, const Match &b) {
+        return a.score != b.score ? a.score > b.score : a.date > b.date;
+    });
+    matches.resize(limit);
+    return matches;
+}
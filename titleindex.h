@@ -0,0 +1,59 @@
+#ifndef TITLEINDEX_H
+#define TITLEINDEX_H
+
+#include <QString>
+#include <QStringList>
+#include <QDate>
+#include <QList>
+#include <QHash>
+
+// 壁纸标题的倒排索引，输入时即时搜索
+// 英文等按单词切分(大小写、全角半角、重音统一)，中日韩文字按单字和相邻两字(bigram)切分；
+// 每个词对应按日期排序的日期列表，文件中以变长整数差值保存
+class TitleIndex
+{
+public:
+    struct Match {
+        QDate date;
+        double score;
+    };
+
+    explicit TitleIndex(const QString &filePath = QString());
+
+    // 索引使用的词；query为true时中日韩文字只取bigram(单字时取单字)，末尾未输入完的单词作为前缀
+    struct Token {
+        QString text;
+        bool prefix;
+    };
+    static QList<Token> tokenize(const QString &text, bool query = false);
+
+    bool contains(const QDate &date) const;
+    // 已收录的日期不再重复收录
+    void insert(const QDate &date, const QString &title);
+
+    // 包含所有查询词的日期，按相关度和日期排序
+    QList<Match> search(const QString &query, int limit) const;
+
+    bool hasPending() const { return dirty; }
+    bool commit();
+
+private:
+    struct Header {
+        quint32 magic;
+        quint32 version;
+        quint32 termCount;
+        quint32 dayCount;
+    };
+
+    void load();
+    QList<quint16> prefixPostings(const QString &prefix) const;
+    static int dayOffset(const QDate &date);
+
+    QString filePath;
+    QHash<QString, QList<quint16>> postings;  // 词 -> 距2010-01-01的天数(升序)
+    QList<quint8> tokenCounts;               // 按天数下标，每个标题的词数，0表示未收录
+    mutable QStringList sortedTerms;         // 前缀查找用，新增词后重新生成
+    bool dirty = false;
+};
+
+#endif // TITLEINDEX_H
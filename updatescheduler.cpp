@@ -0,0 +1,141 @@
+#include "updatescheduler.h"
+
+#include <QTimeZone>
+#include <QRandomGenerator>
+
+namespace {
+// 定时任务本身会延迟几分钟，发布后再等1~8分钟
+const int minJitter = 60 * 1000;
+const int maxJitter = 8 * 60 * 1000;
+// 退避从5分钟开始，最长2小时
+const int minRetry = 5 * 60 * 1000;
+const int maxRetry = 2 * 60 * 60 * 1000;
+// 错过的更新等网络恢复后再补
+const int catchUpDelay = 60 * 1000;
+// 最长睡眠时间，期间系统睡眠或时间变化也能按实际时间校正
+const int maxWait = 4 * 60 * 60 * 1000;
+}
+
+UpdateScheduler::UpdateScheduler(QObject *parent)
+    : QObject(parent)
+{
+    timer.setSingleShot(true);
+    timer.setTimerType(Qt::VeryCoarseTimer);
+    connect(&timer, &QTimer::timeout, this, &UpdateScheduler::onTimeout);
+}
+
+void UpdateScheduler::start(const QDate &lastApplied)
+{
+    active = true;
+    awaiting = false;
+    failures = 0;
+    if (lastApplied != appliedDate) {
+        appliedDate = lastApplied;
+        appliedAt = QDateTime();
+    }
+    plan();
+}
+
+void UpdateScheduler::stop()
+{
+    active = false;
+    awaiting = false;
+    timer.stop();
+    wakeAt = QDateTime();
+}
+
+void UpdateScheduler::applied(const QDate &date)
+{
+    appliedDate = date;
+    appliedAt = QDateTime::currentDateTimeUtc();
+    awaiting = false;
+    failures = 0;
+    plan();
+}
+
+void UpdateScheduler::retryLater()
+{
+    if (!awaiting) {
+        return;
+    }
+    awaiting = false;
+    ++failures;
+    plan();
+}
+
+void UpdateScheduler::catchUp()
+{
+    plan();
+}
+
+QDateTime UpdateScheduler::publicationTime(const QDate &date)
+{
+    // 北京时间date日0:10，即前一天16:10 UTC
+    return QDateTime(date.addDays(-1), QTime(16, 10), QTimeZone::UTC);
+}
+
+QDateTime UpdateScheduler::availableTime(const QDate &date)
+{
+    // 本地时间到了该日且已经发布
+    return qMax(publicationTime(date), date.startOfDay().toUTC());
+}
+
+QDateTime UpdateScheduler::nextTarget(const QDateTime &now) const
+{
+    QDate today = now.toLocalTime().date();
+    QDateTime todayAvailable = availableTime(today);
+
+    // 已是今日壁纸，或今日壁纸发布后手动选择了其他日期：等下一次发布
+    if (appliedDate == today || (appliedAt.isValid() && appliedAt >= todayAvailable)) {
+        return availableTime(today.addDays(1));
+    }
+
+    QDateTime target = todayAvailable;
+    if (failures > 0) {
+        qint64 retry = qMin<qint64>(qint64(minRetry) << qMin(failures - 1, 10), maxRetry);
+        target = qMax(target, now.addMSecs(retry));
+    }
+    return target;
+}
+
+void UpdateScheduler::plan()
+{
+    if (!active) {
+        return;
+    }
+
+    QDateTime now = QDateTime::currentDateTimeUtc();
+    QDateTime target = nextTarget(now);
+    if (target > now) {
+        target = target.addMSecs(QRandomGenerator::global()->bounded(minJitter, maxJitter));
+    } else {
+        target = now.addMSecs(catchUpDelay);
+    }
+    targetAt = target;
+
+    qint64 wait = qBound<qint64>(0, now.msecsTo(target), maxWait);
+    wakeAt = now.addMSecs(wait);
+    timer.start(int(wait));
+}
+
+void UpdateScheduler::onTimeout()
+{
+    QDateTime now = QDateTime::currentDateTimeUtc();
+    // 只是到了最长睡眠时间，重新按实际时间计算
+    if (now.addSecs(5) < targetAt) {
+        plan();
+        return;
+    }
+
+    // 上次due之后一直没有结果，按失败处理
+    if (awaiting) {
+        ++failures;
+    }
+    awaiting = true;
+    // 没有收到结果(例如请求被用户操作取消)时也会在退避后再次检查
+    qint64 retry = qMin<qint64>(qint64(minRetry) << qMin(failures, 10), maxRetry);
+    targetAt = now.addMSecs(retry);
+    wakeAt = targetAt;
+    timer.start(int(retry));
+    emit due();
+}
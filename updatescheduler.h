@@ -0,0 +1,53 @@
+#ifndef UPDATESCHEDULER_H
+#define UPDATESCHEDULER_H
+
+#include <QObject>
+#include <QDate>
+#include <QDateTime>
+#include <QTimer>
+
+// 每日更新的计划：按新壁纸的发布时间唤醒，而不是固定间隔轮询
+// 某日(本地日期)的壁纸在前一天16:10 UTC由定时任务抓取，发布后加随机延迟再检查；
+// 没取到新壁纸时按指数退避重试；睡眠唤醒或系统时间变化后重新计算并补上错过的更新
+class UpdateScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit UpdateScheduler(QObject *parent = nullptr);
+
+    // 开始计划，lastApplied为上次设置的壁纸日期
+    void start(const QDate &lastApplied);
+    void stop();
+    bool isActive() const { return active; }
+
+    // 已设置date的壁纸；手动选择的其他日期保留到下一次发布
+    void applied(const QDate &date);
+    // due之后没有取到新壁纸(尚未发布或网络错误)，退避后重试
+    void retryLater();
+    // 睡眠唤醒、系统时间变化后调用
+    void catchUp();
+
+    QDateTime nextWake() const { return wakeAt; }
+
+signals:
+    void due();
+
+private:
+    static QDateTime publicationTime(const QDate &date);
+    static QDateTime availableTime(const QDate &date);
+    QDateTime nextTarget(const QDateTime &now) const;
+    void plan();
+    void onTimeout();
+
+    QTimer timer;
+    QDate appliedDate;
+    QDateTime appliedAt;
+    QDateTime targetAt;
+    QDateTime wakeAt;
+    int failures = 0;
+    bool active = false;
+    bool awaiting = false;
+};
+
+#endif // UPDATESCHEDULER_H
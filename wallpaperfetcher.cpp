@@ -0,0 +1,614 @@
+#include "wallpaperfetcher.h"
+
+#include <QTimer>
+#include <QUrl>
+#include <QFile>
+#include <QDate>
+#include <QJsonDocument>
+#include <QImageReader>
+#include <QRegularExpression>
+
+WallpaperFetcher::WallpaperFetcher(QObject *parent)
+    : QObject(parent)
+    , networkManager(new NetworkManager(this))
+{
+    setMetadataMirrors(QStringList());
+    // bing的两个域名提供相同的图片
+    imageMirrors.setBaseUrls({"https://www.bing.com/", "https://cn.bing.com/"});
+}
+
+void WallpaperFetcher::setMetadataMirrors(const QStringList &baseUrls)
+{
+    // 空白的项会被忽略，全部为空白时同样使用默认数据源
+    metadataMirrors.setBaseUrls(baseUrls);
+    if (metadataMirrors.count() == 0) {
+        // 与readme中的数据源一致：阿里云OSS、GitHub仓库及其同步到的Gitee仓库(wallpaperarchiv分支)
+        metadataMirrors.setBaseUrls({
+            "https://my-bing-wallpaper.oss-cn-beijing.aliyuncs.com/",
+            "https://raw.githubusercontent.com/hanhuang22/mybingwallpaper/wallpaperarchiv/",
+            "https://gitee.com/Hyman25/mybingwallpaper/raw/wallpaperarchiv/",
+        });
+    }
+}
+
+QString WallpaperFetcher::mirrorSummary() const
+{
+    return metadataMirrors.summary() + "\n" + imageMirrors.summary();
+}
+
+void WallpaperFetcher::setDeadline(Stage stage, int msecs)
+{
+    deadlines[stage] = msecs;
+}
+
+void WallpaperFetcher::setImageSegments(int count)
+{
+    imageSegments = qMax(1, count);
+}
+
+bool WallpaperFetcher::isBusy(Stage stage) const
+{
+    if (stage == ImageStage) {
+        return !imageDownload.isNull();
+    }
+    return !replies[stage].isNull() || !hedged[stage].isNull();
+}
+
+void WallpaperFetcher::cancel(Stage stage)
+{
+    abortStage(stage);
+    updateForegroundBusy();
+}
+
+void WallpaperFetcher::updateForegroundBusy()
+{
+    bool busy = !imageDownload.isNull();
+    for (int stage = 0; stage < StageCount; ++stage) {
+        busy = busy || !replies[stage].isNull() || !hedged[stage].isNull();
+    }
+    if (busy != foregroundBusy) {
+        foregroundBusy = busy;
+        emit foregroundBusyChanged(busy);
+    }
+}
+
+void WallpaperFetcher::abortStage(Stage stage)
+{
+    if (stage == ImageStage && imageDownload) {
+        // 已下载的部分保留，下次下载同一图片时续传
+        RangedDownload *download = imageDownload;
+        imageDownload = nullptr;
+        download->disconnect(this);
+        download->abort();
+        download->deleteLater();
+    }
+
+    HedgedRequest *request = hedged[stage];
+    hedged[stage] = nullptr;
+    if (request) {
+        request->disconnect(this);
+        request->abort();
+        request->deleteLater();
+    }
+
+    QNetworkReply *reply = replies[stage];
+    replies[stage] = nullptr;
+    if (reply) {
+        // 先断开连接，被取消的请求不再发出任何结果
+        reply->disconnect(this);
+        reply->abort();
+        reply->deleteLater();
+    }
+}
+
+QNetworkReply *WallpaperFetcher::startStage(Stage stage, const QNetworkRequest &request)
+{
+    // 同一阶段只保留最新的请求
+    abortStage(stage);
+
+    QNetworkReply *reply = networkManager->get(request);
+    replies[stage] = reply;
+    updateForegroundBusy();
+
+    // 本阶段的截止时间，计时器随reply一起销毁
+    QTimer::singleShot(deadlines[stage], reply, [reply]() {
+        reply->setProperty("timedOut", true);
+        reply->abort();
+    });
+
+    return reply;
+}
+
+HedgedRequest *WallpaperFetcher::startHedged(Stage stage, MirrorSet *mirrors, const QNetworkRequest &request,
+                                            const QString &path, std::function<bool(QNetworkReply *)> validator)
+{
+    abortStage(stage);
+
+    HedgedRequest *hedgedRequest = new HedgedRequest(networkManager, mirrors, request, path, this);
+    hedgedRequest->setDeadline(deadlines[stage]);
+    hedgedRequest->setValidator(std::move(validator));
+    hedged[stage] = hedgedRequest;
+    updateForegroundBusy();
+    hedgedRequest->start();
+    return hedgedRequest;
+}
+
+void WallpaperFetcher::finishHedged(Stage stage, HedgedRequest *request)
+{
+    if (hedged[stage].data() == request) {
+        hedged[stage] = nullptr;
+    }
+    request->deleteLater();
+}
+
+bool WallpaperFetcher::finishStage(Stage stage, QNetworkReply *reply, const QString &what)
+{
+    if (replies[stage] == reply) {
+        replies[stage] = nullptr;
+    }
+    reply->deleteLater();
+    updateForegroundBusy();
+
+    bool isTimeout = reply->property("timedOut").toBool();
+    if (!isTimeout && reply->error() == QNetworkReply::NoError) {
+        return true;
+    }
+
+    QString errorMsg;
+    switch (stage) {
+    case MetadataStage:
+        errorMsg = isTimeout ?
+            tr("获取壁纸信息超时") :
+            tr("网络请求失败: ") + reply->errorString();
+        break;
+    case PreviewStage:
+        errorMsg = isTimeout ?
+            tr("预览图片下载超时") :
+            tr("预览图片下载失败: ") + reply->errorString();
+        break;
+    default:
+        errorMsg = isTimeout ?
+            tr("下载壁纸超时: ") + what :
+            tr("下载壁纸失败: ") + reply->errorString();
+        break;
+    }
+    emit failed(stage, errorMsg);
+    return false;
+}
+
+void WallpaperFetcher::warmConnections()
+{
+    networkManager->warmUp({metadataHostUrl(), QUrl("https://www.bing.com/")});
+}
+
+QUrl WallpaperFetcher::metadataHostUrl() const
+{
+    return metadataMirrors.baseUrl(metadataMirrors.best());
+}
+
+QNetworkRequest WallpaperFetcher::monthRequest(const QString &yearMonth) const
+{
+    // 读取月度JSON文件URL，后台请求只用当前最快的镜像
+    QUrl jsonurl = metadataMirrors.url(metadataMirrors.best(), "month/" + yearMonth + ".json");
+    QNetworkRequest request(jsonurl);
+    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+    monthCache.addValidators(yearMonth, request);
+    return request;
+}
+
+QByteArray WallpaperFetcher::monthReplyData(QNetworkReply *reply, const QString &yearMonth)
+{
+    // 304: 本地缓存仍然是最新的
+    int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (status == 304) {
+        return monthCache.load(yearMonth);
+    }
+
+    QByteArray jsonData = reply->readAll();
+    if (!isMonthReply(reply, jsonData)) {
+        return QByteArray();
+    }
+    monthCache.store(yearMonth, jsonData, reply->rawHeader("ETag"), reply->rawHeader("Last-Modified"));
+    return jsonData;
+}
+
+bool WallpaperFetcher::isMonthReply(QNetworkReply *reply, const QByteArray &data)
+{
+    if (reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() == 304) {
+        return true;
+    }
+    return QJsonDocument::fromJson(data).isObject();
+}
+
+void WallpaperFetcher::fetchMetadata(const QString &date)
+{
+    // 从日期字符串提取年月信息，用于构建月度文件路径
+    QString yearMonth = date.left(6); // 从yyyyMMdd格式的日期中获取yyyyMM部分
+
+    // 已发布的日期不会再变化，存档索引或内存索引中已有时直接返回
+    QString imgtitle, imgurl;
+    if (archiveIndex.lookup(QDate::fromString(date, "yyyyMMdd"), &imgtitle, &imgurl)
+        || metadataIndex.lookup(date, &imgtitle, &imgurl) == MetadataIndex::Found) {
+        cancel(MetadataStage);
+        emit metadataReady(date, imgtitle, imgurl);
+        return;
+    }
+
+    // 已结束的月份不会再变化，直接读取本地缓存
+    if (monthCache.isImmutable(yearMonth)) {
+        cancel(MetadataStage);
+        if (metadataIndex.hasMonth(yearMonth)) {
+            lookupMetadata(date);
+        } else {
+            resolveMetadata(date, monthCache.load(yearMonth));
+        }
+        return;
+    }
+
+    // 多个镜像对冲请求，校验信息(ETag等)来自上次响应的镜像，其他镜像不匹配时返回完整文件
+    // 内容不是json的镜像记为失败，不计入延迟统计，也不写入缓存
+    HedgedRequest *request = startHedged(MetadataStage, &metadataMirrors, monthRequest(yearMonth),
+                                         "month/" + yearMonth + ".json", [](QNetworkReply *reply) {
+        return isMonthReply(reply, reply->peek(reply->bytesAvailable()));
+    });
+    connect(request, &HedgedRequest::finished, this, [this, request, date, yearMonth](QNetworkReply *reply) {
+        finishHedged(MetadataStage, request);
+        if (!finishStage(MetadataStage, reply, date)) {
+            return;
+        }
+
+        // 304且该月已在索引中时无需重新解析
+        if (reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() == 304
+            && metadataIndex.hasMonth(yearMonth)) {
+            lookupMetadata(date);
+            return;
+        }
+        resolveMetadata(date, monthReplyData(reply, yearMonth));
+    });
+}
+
+MetadataIndex::ParseResult WallpaperFetcher::ingestMonth(const QString &yearMonth, const QByteArray &jsonData)
+{
+    MetadataIndex::ParseResult result = metadataIndex.addMonth(yearMonth, jsonData);
+    if (result != MetadataIndex::Parsed) {
+        return result;
+    }
+
+    // 同步写入存档索引和标题索引，下次启动后无需再解析
+    QDate firstDay = QDate::fromString(yearMonth + "01", "yyyyMMdd");
+    QString imgtitle, imgurl;
+    for (int day = 0; day < firstDay.daysInMonth(); ++day) {
+        QDate date = firstDay.addDays(day);
+        if (metadataIndex.lookup(date.toString("yyyyMMdd"), &imgtitle, &imgurl) == MetadataIndex::Found) {
+            archiveIndex.insert(date, imgtitle, imgurl);
+            titles.insert(date, imgtitle);
+        }
+    }
+    return result;
+}
+
+void WallpaperFetcher::resolveMetadata(const QString &date, const QByteArray &jsonData)
+{
+    // 整个月度文件只解析一次，之后的查找都走索引
+    switch (ingestMonth(date.left(6), jsonData)) {
+    case MetadataIndex::InvalidJson:
+        emit failed(MetadataStage, tr("JSON数据解析失败"));
+        return;
+    case MetadataIndex::NotAnObject:
+        emit failed(MetadataStage, tr("JSON格式不支持"));
+        return;
+    default:
+        break;
+    }
+
+    // 建立索引期间由buildNextMonth统一写入
+    if (indexPendingMonths.isEmpty()) {
+        commitIndexes();
+    }
+    lookupMetadata(date);
+}
+
+void WallpaperFetcher::lookupMetadata(const QString &date)
+{
+    QString imgtitle, imgurl;
+    switch (metadataIndex.lookup(date, &imgtitle, &imgurl)) {
+    case MetadataIndex::Found:
+        emit metadataReady(date, imgtitle, imgurl);
+        break;
+    case MetadataIndex::InfoMissing:
+        emit failed(MetadataStage, tr("获取图片信息失败"));
+        break;
+    default:
+        emit failed(MetadataStage, tr("未找到该日期壁纸数据"));
+        break;
+    }
+}
+
+QUrl WallpaperFetcher::previewUrl(const QString &imgurl)
+{
+    if (imgurl.contains("bing.com")) {
+        return QUrl(imgurl+"&w=480");
+    }
+    return QUrl(imgurl);
+}
+
+void WallpaperFetcher::fetchPreview(const QString &imgurl)
+{
+    // 磁盘缓存命中时不访问网络
+    QByteArray cached = previews.data(imgurl);
+    if (!cached.isEmpty()) {
+        cancel(PreviewStage);
+        emit previewReady(imgurl, cached);
+        return;
+    }
+
+    auto onReply = [this, imgurl](QNetworkReply *reply) {
+        if (!finishStage(PreviewStage, reply, imgurl)) {
+            return;
+        }
+        QByteArray data = reply->readAll();
+        previews.insertData(imgurl, data);
+        emit previewReady(imgurl, data);
+    };
+
+    // bing的图片可以从两个域名获取，对冲请求
+    QUrl url = previewUrl(imgurl);
+    if (url.host().endsWith("bing.com")) {
+        QString path = url.path(QUrl::FullyEncoded).mid(1);
+        if (url.hasQuery()) {
+            path += "?" + url.query(QUrl::FullyEncoded);
+        }
+        HedgedRequest *request = startHedged(PreviewStage, &imageMirrors, QNetworkRequest(url), path);
+        connect(request, &HedgedRequest::finished, this, [this, request, onReply](QNetworkReply *reply) {
+            finishHedged(PreviewStage, request);
+            onReply(reply);
+        });
+        return;
+    }
+
+    QNetworkReply *reply = startStage(PreviewStage, QNetworkRequest(url));
+    connect(reply, &QNetworkReply::finished, this, [reply, onReply]() {
+        onReply(reply);
+    });
+}
+
+void WallpaperFetcher::fetchImage(const QString &imgurl)
+{
+    abortStage(ImageStage);
+
+    // 已存储的图片直接使用，不访问网络
+    QString storedPath = store.find(imgurl);
+    if (!storedPath.isEmpty()) {
+        updateForegroundBusy();
+        emit imageReady(imgurl, storedPath);
+        return;
+    }
+    QString filePath = store.incomingPath(imgurl);
+
+    // 断点续传，大图分段并行下载；分段数据先写入分段文件，完成后原子替换目标文件
+    RangedDownload *download = new RangedDownload(networkManager, QUrl(imgurl), filePath, this);
+    download->setMaxSegments(imageSegments);
+    download->setStallTimeout(deadlines[ImageStage]);
+    imageDownload = download;
+
+    connect(download, &RangedDownload::finished, this, [this, download, imgurl, filePath]() {
+        finishDownload(download);
+
+        // 按内容移入存储，相同图片只保存一份
+        QString path = store.add(imgurl, filePath);
+        if (path.isEmpty()) {
+            emit failed(ImageStage, tr("无法保存壁纸到临时文件!"));
+            return;
+        }
+        emit imageReady(imgurl, path);
+    });
+    connect(download, &RangedDownload::failed, this,
+            [this, download, imgurl](RangedDownload::Error error, const QString &errorString) {
+        finishDownload(download);
+
+        QString errorMsg;
+        switch (error) {
+        case RangedDownload::TimeoutError:
+            errorMsg = tr("下载壁纸超时: ") + imgurl;
+            break;
+        case RangedDownload::WriteError:
+            errorMsg = tr("无法保存壁纸到临时文件!");
+            break;
+        default:
+            errorMsg = tr("下载壁纸失败: ") + errorString;
+            break;
+        }
+        emit failed(ImageStage, errorMsg);
+    });
+
+    updateForegroundBusy();
+    download->start();
+}
+
+void WallpaperFetcher::finishDownload(RangedDownload *download)
+{
+    if (imageDownload.data() == download) {
+        imageDownload = nullptr;
+    }
+    download->deleteLater();
+    updateForegroundBusy();
+}
+
+void WallpaperFetcher::buildArchiveIndex()
+{
+    indexPendingMonths.clear();
+
+    // 月末(当月为今天)已收录的月份视为完整，跳过
+    QDate today = QDate::currentDate();
+    for (QDate month = ArchiveIndex::firstDate(); month <= today; month = month.addMonths(1)) {
+        QDate lastDay = qMin(month.addDays(month.daysInMonth() - 1), today);
+        if (!archiveIndex.contains(lastDay)) {
+            indexPendingMonths.append(month.toString("yyyyMM"));
+        }
+    }
+
+    buildNextMonth();
+}
+
+void WallpaperFetcher::buildNextMonth()
+{
+    if (indexPendingMonths.isEmpty()) {
+        commitIndexes();
+        emit archiveIndexBuilt(archiveIndex.dayCount());
+        return;
+    }
+
+    QString yearMonth = indexPendingMonths.first();
+
+    // 本地已有完整的月份文件时无需请求网络
+    if (monthCache.isImmutable(yearMonth)) {
+        bool ok = ingestMonth(yearMonth, monthCache.load(yearMonth)) == MetadataIndex::Parsed;
+        indexPendingMonths.removeFirst();
+        emit archiveIndexProgress(yearMonth, ok);
+        // 通过事件队列继续，避免本地月份较多时递归过深
+        QMetaObject::invokeMethod(this, &WallpaperFetcher::buildNextMonth, Qt::QueuedConnection);
+        return;
+    }
+
+    QNetworkRequest request = monthRequest(yearMonth);
+    request.setTransferTimeout(deadlines[MetadataStage]);
+    QNetworkReply *reply = networkManager->get(request);
+    connect(reply, &QNetworkReply::finished, this, [this, reply, yearMonth]() {
+        reply->deleteLater();
+        bool ok = reply->error() == QNetworkReply::NoError
+            && ingestMonth(yearMonth, monthReplyData(reply, yearMonth)) == MetadataIndex::Parsed;
+        // 失败的月份留到下次建立索引时再获取
+        indexPendingMonths.removeFirst();
+        emit archiveIndexProgress(yearMonth, ok);
+        buildNextMonth();
+    });
+}
+
+void WallpaperFetcher::updateTitleIndex()
+{
+    QDate today = QDate::currentDate();
+    QString imgtitle, imgurl;
+    for (QDate date = ArchiveIndex::firstDate(); date <= today; date = date.addDays(1)) {
+        if (!titles.contains(date) && archiveIndex.lookup(date, &imgtitle, &imgurl)) {
+            titles.insert(date, imgtitle);
+        }
+    }
+    titles.commit();
+}
+
+void WallpaperFetcher::commitIndexes()
+{
+    archiveIndex.commit();
+    titles.commit();
+}
+
+bool WallpaperFetcher::cachedMetadata(const QString &date, QString *imgtitle, QString *imgurl)
+{
+    if (archiveIndex.lookup(QDate::fromString(date, "yyyyMMdd"), imgtitle, imgurl)) {
+        return true;
+    }
+
+    // 本地已有完整月份文件时顺便建立索引
+    QString yearMonth = date.left(6);
+    if (!metadataIndex.hasMonth(yearMonth) && monthCache.isImmutable(yearMonth)) {
+        ingestMonth(yearMonth, monthCache.load(yearMonth));
+        if (indexPendingMonths.isEmpty()) {
+            commitIndexes();
+        }
+    }
+    return metadataIndex.lookup(date, imgtitle, imgurl) == MetadataIndex::Found;
+}
+
+QNetworkReply *WallpaperFetcher::warmMonth(const QString &yearMonth)
+{
+    if (monthCache.isImmutable(yearMonth)) {
+        return nullptr;
+    }
+
+    QNetworkRequest request = monthRequest(yearMonth);
+    request.setPriority(QNetworkRequest::LowPriority);
+    request.setTransferTimeout(deadlines[MetadataStage]);
+    QNetworkReply *reply = networkManager->get(request);
+    connect(reply, &QNetworkReply::finished, this, [this, reply, yearMonth]() {
+        reply->deleteLater();
+        if (reply->error() != QNetworkReply::NoError) {
+            return;
+        }
+        if (reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() == 304
+            && metadataIndex.hasMonth(yearMonth)) {
+            return;
+        }
+        if (ingestMonth(yearMonth, monthReplyData(reply, yearMonth)) == MetadataIndex::Parsed
+            && indexPendingMonths.isEmpty()) {
+            commitIndexes();
+        }
+    });
+    return reply;
+}
+
+// bing图片url中的分辨率标记，例如_UHD、_1920x1080
+static QString resolutionTag(const QString &imgurl)
+{
+    static const QRegularExpression pattern("_(UHD|\\d+x\\d+)\\.jpg", QRegularExpression::CaseInsensitiveOption);
+    return pattern.match(imgurl).captured(1).toUpper();
+}
+
+QString WallpaperFetcher::storedDuplicate(const QString &imgurl, quint64 previewHash, const QSize &previewSize)
+{
+    QString storedPath = store.find(imgurl);
+    if (storedPath.isEmpty()) {
+        storedPath = store.findAlias(imgurl);
+    }
+    if (!storedPath.isEmpty()) {
+        return storedPath;
+    }
+
+    QDate date = perceptual.findDuplicate(previewHash);
+    QString imgtitle, duplicateUrl;
+    if (!date.isValid() || !cachedMetadata(date.toString("yyyyMMdd"), &imgtitle, &duplicateUrl)
+        || resolutionTag(duplicateUrl) != resolutionTag(imgurl)) {
+        return QString();
+    }
+    storedPath = store.find(duplicateUrl);
+    if (storedPath.isEmpty()) {
+        return QString();
+    }
+
+    // 感知哈希只比较缩略图，尺寸也必须一致：url标明分辨率时要求完全相同，
+    // 否则要求与预览图的宽高比相同(按预览图的尺寸误差不超过1像素)
+    const QSize storedSize = QImageReader(storedPath).size();
+    const QString tag = resolutionTag(imgurl);
+    const int x = tag.indexOf('X');
+    if (x > 0) {
+        if (storedSize != QSize(tag.left(x).toInt(), tag.mid(x + 1).toInt())) {
+            return QString();
+        }
+    } else if (!storedSize.isValid() || previewSize.isEmpty()
+               || qAbs(qint64(storedSize.width()) * previewSize.height()
+                       - qint64(storedSize.height()) * previewSize.width()) > storedSize.width()) {
+        return QString();
+    }
+    if (!store.alias(imgurl, storedPath)) {
+        return QString();
+    }
+    return storedPath;
+}
+
+QNetworkReply *WallpaperFetcher::warmPreview(const QString &imgurl)
+{
+    if (previews.contains(imgurl)) {
+        return nullptr;
+    }
+
+    QNetworkRequest request(previewUrl(imgurl));
+    request.setPriority(QNetworkRequest::LowPriority);
+    request.setTransferTimeout(deadlines[PreviewStage]);
+    QNetworkReply *reply = networkManager->get(request);
+    connect(reply, &QNetworkReply::finished, this, [this, reply, imgurl]() {
+        reply->deleteLater();
+        if (reply->error() == QNetworkReply::NoError) {
+            previews.insertData(imgurl, reply->readAll());
+        }
+    });
+    return reply;
+}
@@ -0,0 +1,134 @@
+#ifndef WALLPAPERFETCHER_H
+#define WALLPAPERFETCHER_H
+
+#include <QObject>
+#include <QString>
+#include <QByteArray>
+#include <QPointer>
+#include <QSize>
+#include <QtNetwork/QNetworkAccessManager>
+#include <QtNetwork/QNetworkRequest>
+#include <QtNetwork/QNetworkReply>
+#include "monthcache.h"
+#include "metadataindex.h"
+#include "archiveindex.h"
+#include "previewcache.h"
+#include "rangeddownload.h"
+#include "imagestore.h"
+#include "perceptualindex.h"
+#include "colorindex.h"
+#include "titleindex.h"
+#include "networkmanager.h"
+#include "mirrorset.h"
+#include "hedgedrequest.h"
+#include <QStringList>
+
+// 异步获取壁纸：元数据(月度json)、预览图、原图三个阶段
+// 各阶段互不阻塞、可同时进行，每个阶段有独立的超时时间(原图阶段为无数据超时)；
+// 同一阶段发起新请求时会取消该阶段尚未完成的旧请求
+class WallpaperFetcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Stage {
+        MetadataStage,
+        PreviewStage,
+        ImageStage,
+        StageCount
+    };
+    Q_ENUM(Stage)
+
+    explicit WallpaperFetcher(QObject *parent = nullptr);
+
+    void setDeadline(Stage stage, int msecs);
+    void setImageSegments(int count);
+    bool isBusy(Stage stage) const;
+    void cancel(Stage stage);
+    PreviewCache *previewCache() { return &previews; }
+    ImageStore *imageStore() { return &store; }
+    NetworkManager *network() { return networkManager; }
+    PerceptualIndex *perceptualIndex() { return &perceptual; }
+    ColorIndex *colorIndex() { return &colors; }
+    TitleIndex *titleIndex() { return &titles; }
+    // 预先连接元数据和图片服务器
+    void warmConnections();
+    // 月度json的镜像列表(根目录url)，为空时使用默认的OSS、GitHub和Gitee
+    void setMetadataMirrors(const QStringList &baseUrls);
+    // 当前最快的元数据镜像，网络探测也以它为目标
+    QUrl metadataHostUrl() const;
+    QString mirrorSummary() const;
+
+    // bing的图片可按宽度取小尺寸预览，其他来源的预览即原图
+    static QUrl previewUrl(const QString &imgurl);
+    // 月度json的响应是否可用：304，或内容为json对象(排除状态200的错误页)
+    static bool isMonthReply(QNetworkReply *reply, const QByteArray &data);
+
+    void fetchMetadata(const QString &date);
+    void fetchPreview(const QString &imgurl);
+    // 原图保存在ImageStore中，imageReady给出存储中的路径
+    void fetchImage(const QString &imgurl);
+
+    // 增量建立存档索引：只获取索引中尚未完整收录的月份
+    void buildArchiveIndex();
+    // 把存档索引中已有、标题索引中还没有的日期补进标题索引(升级后的首次运行)
+    void updateTitleIndex();
+
+    // 供后台预取使用：不占用前台阶段、不发出结果信号，请求为低优先级
+    // 已有缓存时warm*返回nullptr
+    bool cachedMetadata(const QString &date, QString *imgtitle, QString *imgurl);
+    QNetworkReply *warmMonth(const QString &yearMonth);
+    QNetworkReply *warmPreview(const QString &imgurl);
+    bool isForegroundBusy() const { return foregroundBusy; }
+
+    // 预览图的感知哈希与某张已存储的图片相同、且分辨率一致时，把imgurl记为该图片的别名
+    // 并返回其路径；没有重复时返回空。别名只用于同步存档，fetchImage仍会下载原图
+    QString storedDuplicate(const QString &imgurl, quint64 previewHash, const QSize &previewSize);
+
+signals:
+    void metadataReady(const QString &date, const QString &imgtitle, const QString &imgurl);
+    void previewReady(const QString &imgurl, const QByteArray &data);
+    void imageReady(const QString &imgurl, const QString &filePath);
+    void failed(WallpaperFetcher::Stage stage, const QString &message);
+    void archiveIndexProgress(const QString &yearMonth, bool ok);
+    void archiveIndexBuilt(int dayCount);
+    void foregroundBusyChanged(bool busy);
+
+private:
+    void abortStage(Stage stage);
+    void updateForegroundBusy();
+    QNetworkReply *startStage(Stage stage, const QNetworkRequest &request);
+    HedgedRequest *startHedged(Stage stage, MirrorSet *mirrors, const QNetworkRequest &request, const QString &path,
+                               std::function<bool(QNetworkReply *)> validator = nullptr);
+    void finishHedged(Stage stage, HedgedRequest *request);
+    bool finishStage(Stage stage, QNetworkReply *reply, const QString &what);
+    QNetworkRequest monthRequest(const QString &yearMonth) const;
+    QByteArray monthReplyData(QNetworkReply *reply, const QString &yearMonth);
+    MetadataIndex::ParseResult ingestMonth(const QString &yearMonth, const QByteArray &jsonData);
+    void resolveMetadata(const QString &date, const QByteArray &jsonData);
+    void lookupMetadata(const QString &date);
+    void finishDownload(RangedDownload *download);
+    void buildNextMonth();
+    void commitIndexes();
+
+    NetworkManager *networkManager;
+    MonthCache monthCache;
+    MetadataIndex metadataIndex;
+    ArchiveIndex archiveIndex;
+    PreviewCache previews;
+    ImageStore store;
+    PerceptualIndex perceptual;
+    ColorIndex colors;
+    TitleIndex titles;
+    QStringList indexPendingMonths;
+    QPointer<QNetworkReply> replies[StageCount];
+    QPointer<HedgedRequest> hedged[StageCount];
+    MirrorSet metadataMirrors;
+    MirrorSet imageMirrors;
+    QPointer<RangedDownload> imageDownload;
+    int imageSegments = 4;
+    int deadlines[StageCount] = {3000, 5000, 8000};
+    bool foregroundBusy = false;
+};
+
+#endif // WALLPAPERFETCHER_H
@@ -0,0 +1,80 @@
+#include "wallpaperrenderer.h"
+#include "resampler.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QSaveFile>
+#include <QImage>
+#include <QImageReader>
+#include <QStandardPaths>
+
+WallpaperRenderer::WallpaperRenderer(const QString &cacheDir, int maxFiles)
+    : cacheDir(cacheDir)
+    , maxFiles(maxFiles)
+{
+    if (this->cacheDir.isEmpty()) {
+        this->cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/rendition";
+    }
+    QDir().mkpath(this->cacheDir);
+}
+
+QString WallpaperRenderer::render(const QString &sourcePath, const QSize &size) const
+{
+    QImageReader reader(sourcePath);
+    QSize sourceSize = reader.size();
+    if (!sourceSize.isValid() || !size.isValid()
+        || (sourceSize.width() <= size.width() && sourceSize.height() <= size.height())) {
+        return sourcePath;
+    }
+
+    // 存储中的文件名就是内容哈希
+    QString path = cacheDir + QString("/%1-%2x%3.jpg")
+        .arg(QFileInfo(sourcePath).completeBaseName()).arg(size.width()).arg(size.height());
+    if (QFileInfo::exists(path)) {
+        // 用修改时间记录最近使用，清理时保留最近的
+        QFile file(path);
+        if (file.open(QIODevice::ReadWrite)) {
+            file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+        }
+        return path;
+    }
+
+    // 只解码与显示器宽高比相同的中间区域
+    QSize cropSize = size.scaled(sourceSize, Qt::KeepAspectRatio);
+    QRect crop(QPoint((sourceSize.width() - cropSize.width()) / 2, (sourceSize.height() - cropSize.height()) / 2),
+               cropSize);
+    reader.setClipRect(crop);
+    QImage image = reader.read();
+    if (image.isNull()) {
+        return sourcePath;
+    }
+    if (image.size() != size) {
+        image = Resampler::scaled(image, size);
+    }
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || !image.save(&file, "JPEG", 95) || !file.commit()) {
+        return sourcePath;
+    }
+    prune();
+    return path;
+}
+
+QStringList WallpaperRenderer::renderAll(const QString &sourcePath, const QList<DesktopMonitor> &monitors) const
+{
+    QStringList paths;
+    for (const DesktopMonitor &monitor : monitors) {
+        paths.append(render(sourcePath, monitor.rect.size()));
+    }
+    return paths;
+}
+
+void WallpaperRenderer::prune() const
+{
+    QFileInfoList files = QDir(cacheDir).entryInfoList({"*.jpg"}, QDir::Files, QDir::Time);
+    for (int i = maxFiles; i < files.size(); ++i) {
+        QFile::remove(files.at(i).absoluteFilePath());
+    }
+}
@@ -0,0 +1,30 @@
+#ifndef WALLPAPERRENDERER_H
+#define WALLPAPERRENDERER_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QSize>
+#include "platform.h"
+
+// 按各显示器的物理分辨率预先生成壁纸
+// 居中裁剪出与显示器相同的宽高比后高质量缩放到显示器尺寸，系统不再每次登录时重新缩放4K原图；
+// 结果以(图片哈希, 尺寸)缓存，同一张图片再次设置时直接使用。可在任意线程调用
+class WallpaperRenderer
+{
+public:
+    explicit WallpaperRenderer(const QString &cacheDir = QString(), int maxFiles = 16);
+
+    // 原图不大于显示器时返回原图路径
+    QString render(const QString &sourcePath, const QSize &size) const;
+    // 与monitors一一对应
+    QStringList renderAll(const QString &sourcePath, const QList<DesktopMonitor> &monitors) const;
+
+private:
+    void prune() const;
+
+    QString cacheDir;
+    int maxFiles;
+};
+
+#endif // WALLPAPERRENDERER_H